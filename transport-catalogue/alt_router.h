@@ -0,0 +1,342 @@
+#pragma once
+
+/**
+ * @file alt_router.h
+ * @brief This file contains the declaration of the AltRouter class, a goal-directed router guided by landmarks.
+ */
+
+#include "graph.h"
+#include "router.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/**
+ * @class AltRouter
+ * @brief Router answering every query with an A* search whose heuristic comes from landmark distances (ALT).
+ * For every landmark the distances from it and to it are precomputed; by the triangle inequality they give
+ * a lower bound of the remaining distance to the target, so the search is steered towards it.
+ * Memory is O(landmarks * V). The graph must be frozen; searches scan its CSR arrays.
+ * @tparam Weight The weight type of the graph.
+ */
+template <typename Weight>
+class AltRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    /**
+     * @struct Landmarks
+     * @brief The landmarks and their distance arrays, as stored in the serialized base.
+     * Both arrays are row-major landmark_count x V; unreachable cells hold Router<Weight>::UNREACHABLE_WEIGHT.
+     */
+    struct Landmarks {
+        std::vector<VertexId> vertices;         /**< The landmark vertices */
+        std::vector<Weight> from_landmarks;     /**< Distances from every landmark to every vertex */
+        std::vector<Weight> to_landmarks;       /**< Distances from every vertex to every landmark */
+    };
+
+    /**
+     * @brief Selects the landmarks and computes their distances.
+     * @param graph The graph.
+     * @param landmark_count The number of landmarks; fewer are used on small graphs.
+     */
+    explicit AltRouter(const Graph& graph, size_t landmark_count = DEFAULT_LANDMARK_COUNT);
+
+    /**
+     * @brief Restores the router from landmarks previously computed for the same graph.
+     */
+    AltRouter(const Graph& graph, Landmarks landmarks);
+
+    /**
+     * @brief Builds the route between two vertices with an A* search.
+     * With a weight limit no vertex is queued whose lower bound of the route through it exceeds the limit,
+     * so the search ends as soon as its frontier does.
+     * @param limits The bounds of the search.
+     * @return The route, or std::nullopt if the target is unreachable within the weight limit.
+     * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+     */
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const SearchLimits<Weight>& limits = {}) const;
+
+    const Landmarks& GetLandmarks() const {
+        return landmarks_;
+    }
+
+    static constexpr size_t DEFAULT_LANDMARK_COUNT = 16;
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    /**
+     * @struct SearchState
+     * @brief Scratch buffers of one search, invalidated by a stamp like in DijkstraRouter.
+     */
+    struct SearchState {
+        std::vector<Weight> weights;
+        std::vector<Weight> potentials;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> stamps;
+        std::vector<QueueItem> queue;
+        uint32_t stamp = 0;
+
+        void Reset(size_t vertex_count) {
+            if (stamps.size() < vertex_count) {
+                weights.resize(vertex_count);
+                potentials.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                stamps.resize(vertex_count, 0);
+            }
+            queue.clear();
+            if (++stamp == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                stamp = 1;
+            }
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return stamps[vertex] == stamp;
+        }
+    };
+
+    /**
+     * @brief Runs a plain Dijkstra search over the edges or the reversed edges and returns all the distances.
+     */
+    std::vector<Weight> ComputeDistances(VertexId from, bool reversed) const;
+
+    /**
+     * @brief Lower bound of the distance from a vertex to the target, skipping the landmarks that give no bound.
+     */
+    Weight GetPotential(VertexId vertex, VertexId to) const;
+
+    void SelectLandmarks(size_t landmark_count);
+    void CheckVertex(VertexId vertex) const {
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight UNREACHABLE_WEIGHT = Router<Weight>::UNREACHABLE_WEIGHT;
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+
+    const Graph& graph_;
+    typename Graph::CsrView csr_;
+    std::vector<std::vector<EdgeId>> incoming_edges_;   /**< Reversed incidence lists, used while computing the landmarks */
+    Landmarks landmarks_;
+};
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, size_t landmark_count)
+    : graph_(graph)
+    , csr_(graph.GetCsr())
+    , incoming_edges_(graph.GetVertexCount())
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (IsNegativeWeight(edge.weight)) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        incoming_edges_[edge.to].push_back(edge_id);
+    }
+    SelectLandmarks(std::min(landmark_count, graph.GetVertexCount()));
+    incoming_edges_.clear();
+    incoming_edges_.shrink_to_fit();
+}
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, Landmarks landmarks)
+    : graph_(graph)
+    , csr_(graph.GetCsr())
+    , landmarks_(std::move(landmarks))
+{
+    const size_t cell_count = landmarks_.vertices.size() * graph.GetVertexCount();
+    if (landmarks_.from_landmarks.size() != cell_count || landmarks_.to_landmarks.size() != cell_count) {
+        throw std::invalid_argument("Landmarks don't match the graph");
+    }
+}
+
+/**
+ * Landmarks are picked by farthest selection: each next landmark is the vertex with the largest total
+ * distance from the landmarks picked so far, which spreads them over the periphery of the network.
+ * The first one is the vertex farthest from vertex 0. The distance arrays of a landmark are two
+ * independent searches and run on a ThreadPool.
+ */
+template <typename Weight>
+void AltRouter<Weight>::SelectLandmarks(size_t landmark_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (landmark_count == 0) {
+        return;
+    }
+
+    threading::ThreadPool pool(2);
+    std::vector<Weight> scores(vertex_count, ZERO_WEIGHT);
+    std::vector<bool> is_landmark(vertex_count, false);
+    std::vector<Weight> from_distances;
+    std::vector<Weight> to_distances;
+    from_distances = ComputeDistances(0, false);
+
+    const auto pick_farthest = [&](const std::vector<Weight>& distances) {
+        VertexId best = vertex_count;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (is_landmark[vertex] || distances[vertex] == UNREACHABLE_WEIGHT) {
+                continue;
+            }
+            if (best == vertex_count || distances[best] < distances[vertex]) {
+                best = vertex;
+            }
+        }
+        return best;
+    };
+
+    VertexId landmark = pick_farthest(from_distances);
+    while (landmark != vertex_count && landmarks_.vertices.size() < landmark_count) {
+        pool.ParallelFor(2, [&](size_t reversed) {
+            (reversed ? to_distances : from_distances) = ComputeDistances(landmark, reversed != 0);
+        });
+        is_landmark[landmark] = true;
+        landmarks_.vertices.push_back(landmark);
+        landmarks_.from_landmarks.insert(landmarks_.from_landmarks.end(), from_distances.begin(), from_distances.end());
+        landmarks_.to_landmarks.insert(landmarks_.to_landmarks.end(), to_distances.begin(), to_distances.end());
+
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            if (from_distances[vertex] != UNREACHABLE_WEIGHT) {
+                scores[vertex] = AddWeights(scores[vertex], from_distances[vertex]);
+            }
+        }
+        landmark = pick_farthest(scores);
+    }
+}
+
+template <typename Weight>
+std::vector<Weight> AltRouter<Weight>::ComputeDistances(VertexId from, bool reversed) const {
+    std::vector<Weight> distances(graph_.GetVertexCount(), UNREACHABLE_WEIGHT);
+    std::vector<QueueItem> queue{{ZERO_WEIGHT, from}};
+    distances[from] = ZERO_WEIGHT;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+        if (distances[vertex] < weight) {
+            continue;
+        }
+        const auto relax = [&](VertexId next, Weight edge_weight) {
+            const Weight candidate_weight = AddWeights(weight, edge_weight);
+            if (distances[next] == UNREACHABLE_WEIGHT || candidate_weight < distances[next]) {
+                distances[next] = candidate_weight;
+                queue.emplace_back(candidate_weight, next);
+                std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            }
+        };
+        if (reversed) {
+            for (const EdgeId edge_id : incoming_edges_[vertex]) {
+                const auto& edge = graph_.GetEdge(edge_id);
+                relax(edge.from, edge.weight);
+            }
+        }
+        else {
+            for (EdgeId i = csr_.offsets[vertex]; i < csr_.offsets[vertex + 1]; ++i) {
+                relax(csr_.targets[i], csr_.weights[i]);
+            }
+        }
+    }
+    return distances;
+}
+
+/**
+ * For a landmark l the triangle inequality gives d(v, t) >= d(l, t) - d(l, v) and d(v, t) >= d(v, l) - d(t, l).
+ * A term with an unreachable distance on the subtracted side or a negative difference bounds nothing and is skipped,
+ * so unsigned weights are never subtracted below zero.
+ */
+template <typename Weight>
+Weight AltRouter<Weight>::GetPotential(VertexId vertex, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    Weight potential = ZERO_WEIGHT;
+    for (size_t landmark = 0; landmark < landmarks_.vertices.size(); ++landmark) {
+        const Weight* from_landmark = landmarks_.from_landmarks.data() + landmark * vertex_count;
+        const Weight* to_landmark = landmarks_.to_landmarks.data() + landmark * vertex_count;
+        if (from_landmark[to] != UNREACHABLE_WEIGHT && from_landmark[vertex] < from_landmark[to]) {
+            potential = std::max(potential, from_landmark[to] - from_landmark[vertex]);
+        }
+        if (to_landmark[vertex] != UNREACHABLE_WEIGHT && to_landmark[to] < to_landmark[vertex]) {
+            potential = std::max(potential, to_landmark[vertex] - to_landmark[to]);
+        }
+    }
+    return potential;
+}
+
+template <typename Weight>
+std::optional<typename AltRouter<Weight>::RouteInfo> AltRouter<Weight>::BuildRoute(VertexId from, VertexId to,
+                                                                                   const SearchLimits<Weight>& limits) const {
+    CheckVertex(from);
+    CheckVertex(to);
+    if (limits.max_weight && IsNegativeWeight(*limits.max_weight)) {
+        return std::nullopt;
+    }
+    const Weight max_weight = limits.max_weight.value_or(std::numeric_limits<Weight>::max());
+    DeadlineCheck deadline_check(limits.deadline);
+
+    thread_local SearchState state;
+    state.Reset(graph_.GetVertexCount());
+
+    const auto reach = [&](VertexId vertex, Weight weight, EdgeId prev_edge) {
+        if (!state.IsReached(vertex)) {
+            state.stamps[vertex] = state.stamp;
+            state.potentials[vertex] = GetPotential(vertex, to);
+        }
+        state.weights[vertex] = weight;
+        state.prev_edges[vertex] = prev_edge;
+        const Weight key = AddWeights(weight, state.potentials[vertex]);
+        if (max_weight < key) {
+            return;
+        }
+        state.queue.emplace_back(key, vertex);
+        std::push_heap(state.queue.begin(), state.queue.end(), std::greater<QueueItem>{});
+    };
+
+    reach(from, ZERO_WEIGHT, NO_EDGE);
+    bool found = false;
+    while (!state.queue.empty()) {
+        deadline_check.Step();
+        std::pop_heap(state.queue.begin(), state.queue.end(), std::greater<QueueItem>{});
+        const auto [key, vertex] = state.queue.back();
+        state.queue.pop_back();
+        const Weight weight = state.weights[vertex];
+        if (AddWeights(weight, state.potentials[vertex]) < key) {
+            continue;
+        }
+        if (vertex == to) {
+            found = true;
+            break;
+        }
+        for (EdgeId i = csr_.offsets[vertex]; i < csr_.offsets[vertex + 1]; ++i) {
+            const VertexId next = csr_.targets[i];
+            const Weight candidate_weight = AddWeights(weight, csr_.weights[i]);
+            if (!state.IsReached(next) || candidate_weight < state.weights[next]) {
+                reach(next, candidate_weight, csr_.edge_ids[i]);
+            }
+        }
+    }
+    if (!found) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = state.prev_edges[to]; edge_id != NO_EDGE; edge_id = state.prev_edges[graph_.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return RouteInfo{state.weights[to], std::move(edges)};
+}
+
+}  // namespace graph
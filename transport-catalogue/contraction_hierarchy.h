@@ -0,0 +1,596 @@
+#pragma once
+
+/**
+ * @file contraction_hierarchy.h
+ * @brief This file contains the declaration of the ContractionHierarchy class, a router with near-linear preprocessing.
+ */
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/**
+ * @class ContractionHierarchy
+ * @brief Router based on contraction hierarchies.
+ * Preprocessing contracts the vertices one by one in order of importance and adds shortcut arcs that keep
+ * the shortest distances between the remaining vertices. A query is a bidirectional search that only goes up
+ * the hierarchy; shortcuts of the found route are unpacked back into the edges of the graph.
+ * Memory is the graph plus the shortcuts.
+ * @tparam Weight The weight type of the graph.
+ */
+template <typename Weight>
+class ContractionHierarchy {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+    /** Arcs [0, E) are the edges of the graph, arc E + i is the i-th shortcut. */
+    using ArcId = size_t;
+
+    /**
+     * @struct Shortcut
+     * @brief Arc replacing the path first + second through a contracted vertex.
+     */
+    struct Shortcut {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        ArcId first;
+        ArcId second;
+    };
+
+    /**
+     * @struct Preprocessing
+     * @brief The result of the preprocessing, as stored in the serialized base.
+     */
+    struct Preprocessing {
+        std::vector<uint32_t> ranks;        /**< The contraction order position of every vertex */
+        std::vector<Shortcut> shortcuts;    /**< The shortcut arcs */
+    };
+
+    /**
+     * @brief Preprocesses the graph.
+     */
+    explicit ContractionHierarchy(const Graph& graph);
+
+    /**
+     * @brief Restores the hierarchy from a previous preprocessing of the same graph.
+     */
+    ContractionHierarchy(const Graph& graph, Preprocessing preprocessing);
+
+    /**
+     * @brief Builds the route between two vertices with a bidirectional upward search.
+     * With a weight limit neither direction queues a vertex beyond it, so both stop once their frontiers exceed it.
+     * @param limits The bounds of the search.
+     * @return The route, or std::nullopt if the target is unreachable within the weight limit.
+     * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+     */
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const SearchLimits<Weight>& limits = {}) const;
+
+    /**
+     * @brief Computes the weights of the routes between every source and every target with bucket-based many-to-many search.
+     * One backward upward search per target leaves the target and its weight in the bucket of every settled vertex;
+     * one forward upward search per source then meets the buckets, so the cost is S + T searches instead of S x T queries.
+     * @return The weights by source, then target; std::nullopt where the target is unreachable.
+     */
+    std::vector<std::vector<std::optional<Weight>>> BuildWeightMatrix(const std::vector<VertexId>& from,
+                                                                      const std::vector<VertexId>& to) const;
+
+    const Preprocessing& GetPreprocessing() const {
+        return preprocessing_;
+    }
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    struct Arc {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+    };
+
+    /**
+     * @struct SearchState
+     * @brief Scratch buffers of one search direction, invalidated by a stamp like in DijkstraRouter.
+     */
+    struct SearchState {
+        std::vector<Weight> weights;
+        std::vector<ArcId> prev_arcs;
+        std::vector<uint32_t> stamps;
+        std::vector<QueueItem> queue;
+        uint32_t stamp = 0;
+
+        void Reset(size_t vertex_count) {
+            if (stamps.size() < vertex_count) {
+                weights.resize(vertex_count);
+                prev_arcs.resize(vertex_count);
+                stamps.resize(vertex_count, 0);
+            }
+            queue.clear();
+            if (++stamp == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                stamp = 1;
+            }
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return stamps[vertex] == stamp;
+        }
+
+        void Reach(VertexId vertex, Weight weight, ArcId prev_arc) {
+            stamps[vertex] = stamp;
+            weights[vertex] = weight;
+            prev_arcs[vertex] = prev_arc;
+            queue.emplace_back(weight, vertex);
+            std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        }
+
+        QueueItem Pop() {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+            const QueueItem item = queue.back();
+            queue.pop_back();
+            return item;
+        }
+    };
+
+    /**
+     * @class Contractor
+     * @brief The state of the preprocessing: the graph of not yet contracted vertices and the witness search.
+     */
+    class Contractor;
+
+    const Arc& GetArc(ArcId arc_id) const {
+        return arcs_[arc_id];
+    }
+
+    ArcId AddShortcut(const Shortcut& shortcut) {
+        preprocessing_.shortcuts.push_back(shortcut);
+        arcs_.push_back({shortcut.from, shortcut.to, shortcut.weight});
+        return arcs_.size() - 1;
+    }
+
+    void BuildUpwardArcs();
+    void UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const;
+
+    /**
+     * @brief Settles every vertex reachable upwards from a vertex and calls visit(vertex, weight) for each one.
+     * @param is_forward Whether the search follows the upward arcs or the downward arcs backwards.
+     */
+    template <typename Visitor>
+    void SearchUpward(SearchState& state, VertexId start, bool is_forward, const Visitor& visit) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr ArcId NO_ARC = std::numeric_limits<ArcId>::max();
+    /** Limit of settled vertices of one witness search; a search that hits it keeps the shortcut. */
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+    /** Tighter limit used only to estimate the priority of a vertex. */
+    static constexpr size_t PRIORITY_SETTLE_LIMIT = 50;
+
+    const Graph& graph_;
+    Preprocessing preprocessing_;
+    std::vector<Arc> arcs_;
+    std::vector<std::vector<ArcId>> upward_arcs_;       /**< Arcs from a vertex to higher ranked ones */
+    std::vector<std::vector<ArcId>> downward_arcs_;     /**< Arcs into a vertex from higher ranked ones */
+};
+
+template <typename Weight>
+class ContractionHierarchy<Weight>::Contractor {
+public:
+    explicit Contractor(ContractionHierarchy& hierarchy)
+        : hierarchy_(hierarchy)
+        , vertex_count_(hierarchy.graph_.GetVertexCount())
+        , out_arcs_(vertex_count_)
+        , in_arcs_(vertex_count_)
+        , contracted_(vertex_count_, false)
+        , contracted_neighbors_(vertex_count_, 0)
+    {
+        for (ArcId arc_id = 0; arc_id < hierarchy_.arcs_.size(); ++arc_id) {
+            const Arc& arc = hierarchy_.arcs_[arc_id];
+            if (arc.from != arc.to) {
+                out_arcs_[arc.from].push_back(arc_id);
+                in_arcs_[arc.to].push_back(arc_id);
+            }
+        }
+    }
+
+    /**
+     * @brief Contracts all the vertices, lazily updating their priorities, and fills the ranks.
+     */
+    void Run() {
+        std::vector<std::pair<long long, VertexId>> queue;
+        for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+            queue.emplace_back(GetPriority(vertex), vertex);
+        }
+        std::make_heap(queue.begin(), queue.end(), std::greater<>{});
+
+        hierarchy_.preprocessing_.ranks.assign(vertex_count_, 0);
+        uint32_t rank = 0;
+        while (!queue.empty()) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<>{});
+            const VertexId vertex = queue.back().second;
+            queue.pop_back();
+
+            const long long priority = GetPriority(vertex);
+            if (!queue.empty() && priority > queue.front().first) {
+                queue.emplace_back(priority, vertex);
+                std::push_heap(queue.begin(), queue.end(), std::greater<>{});
+                continue;
+            }
+            Contract(vertex, false);
+            hierarchy_.preprocessing_.ranks[vertex] = rank++;
+        }
+    }
+
+private:
+    /**
+     * @brief The cheapest arc from or to one neighbor of the contracted vertex.
+     */
+    struct NeighborArc {
+        VertexId neighbor;
+        Weight weight;
+        ArcId arc_id;
+    };
+
+    std::vector<NeighborArc> GetCheapestArcs(const std::vector<ArcId>& arc_ids, bool incoming) const {
+        std::vector<NeighborArc> neighbor_arcs;
+        for (const ArcId arc_id : arc_ids) {
+            const Arc& arc = hierarchy_.arcs_[arc_id];
+            const VertexId neighbor = incoming ? arc.from : arc.to;
+            auto it = std::find_if(neighbor_arcs.begin(), neighbor_arcs.end(),
+                                   [neighbor](const NeighborArc& neighbor_arc) { return neighbor_arc.neighbor == neighbor; });
+            if (it == neighbor_arcs.end()) {
+                neighbor_arcs.push_back({neighbor, arc.weight, arc_id});
+            }
+            else if (arc.weight < it->weight) {
+                *it = {neighbor, arc.weight, arc_id};
+            }
+        }
+        return neighbor_arcs;
+    }
+
+    /**
+     * @brief Contracts a vertex: adds the shortcuts it needs and removes it from the graph.
+     * @param simulate If true, only counts the shortcuts and changes nothing.
+     * @return The number of shortcuts needed.
+     */
+    size_t Contract(VertexId vertex, bool simulate) {
+        const std::vector<NeighborArc> incoming = GetCheapestArcs(in_arcs_[vertex], true);
+        const std::vector<NeighborArc> outgoing = GetCheapestArcs(out_arcs_[vertex], false);
+
+        size_t shortcut_count = 0;
+        for (const NeighborArc& in : incoming) {
+            Weight max_weight = ZERO_WEIGHT;
+            for (const NeighborArc& out : outgoing) {
+                if (out.neighbor != in.neighbor) {
+                    max_weight = std::max(max_weight, AddWeights(in.weight, out.weight));
+                }
+            }
+            WitnessSearch(in.neighbor, vertex, max_weight, simulate ? PRIORITY_SETTLE_LIMIT : WITNESS_SETTLE_LIMIT);
+
+            for (const NeighborArc& out : outgoing) {
+                if (out.neighbor == in.neighbor) {
+                    continue;
+                }
+                const Weight weight = AddWeights(in.weight, out.weight);
+                if (state_.IsReached(out.neighbor) && !(weight < state_.weights[out.neighbor])) {
+                    continue;
+                }
+                ++shortcut_count;
+                if (!simulate) {
+                    const ArcId arc_id = hierarchy_.AddShortcut({in.neighbor, out.neighbor, weight, in.arc_id, out.arc_id});
+                    out_arcs_[in.neighbor].push_back(arc_id);
+                    in_arcs_[out.neighbor].push_back(arc_id);
+                }
+            }
+        }
+
+        if (!simulate) {
+            for (const ArcId arc_id : in_arcs_[vertex]) {
+                const VertexId neighbor = hierarchy_.arcs_[arc_id].from;
+                auto& arcs = out_arcs_[neighbor];
+                arcs.erase(std::remove(arcs.begin(), arcs.end(), arc_id), arcs.end());
+                ++contracted_neighbors_[neighbor];
+            }
+            for (const ArcId arc_id : out_arcs_[vertex]) {
+                const VertexId neighbor = hierarchy_.arcs_[arc_id].to;
+                auto& arcs = in_arcs_[neighbor];
+                arcs.erase(std::remove(arcs.begin(), arcs.end(), arc_id), arcs.end());
+                ++contracted_neighbors_[neighbor];
+            }
+            in_arcs_[vertex].clear();
+            out_arcs_[vertex].clear();
+            contracted_[vertex] = true;
+        }
+        return shortcut_count;
+    }
+
+    /**
+     * @brief Priority of a vertex: the edge difference of its contraction plus its contracted neighbors.
+     */
+    long long GetPriority(VertexId vertex) {
+        const long long shortcut_count = static_cast<long long>(Contract(vertex, true));
+        const long long removed_count = static_cast<long long>(in_arcs_[vertex].size() + out_arcs_[vertex].size());
+        return shortcut_count - removed_count + static_cast<long long>(contracted_neighbors_[vertex]);
+    }
+
+    /**
+     * @brief Searches the not yet contracted graph from a vertex, avoiding another one, up to a weight and a settle limit.
+     */
+    void WitnessSearch(VertexId from, VertexId avoided, Weight max_weight, size_t settle_limit) {
+        state_.Reset(vertex_count_);
+        state_.Reach(from, ZERO_WEIGHT, NO_ARC);
+        size_t settled_count = 0;
+        while (!state_.queue.empty()) {
+            const auto [weight, vertex] = state_.Pop();
+            if (state_.weights[vertex] < weight) {
+                continue;
+            }
+            if (max_weight < weight || ++settled_count > settle_limit) {
+                break;
+            }
+            for (const ArcId arc_id : out_arcs_[vertex]) {
+                const Arc& arc = hierarchy_.arcs_[arc_id];
+                if (arc.to == avoided) {
+                    continue;
+                }
+                const Weight candidate_weight = AddWeights(weight, arc.weight);
+                if (!state_.IsReached(arc.to) || candidate_weight < state_.weights[arc.to]) {
+                    state_.Reach(arc.to, candidate_weight, arc_id);
+                }
+            }
+        }
+    }
+
+    ContractionHierarchy& hierarchy_;
+    size_t vertex_count_;
+    std::vector<std::vector<ArcId>> out_arcs_;
+    std::vector<std::vector<ArcId>> in_arcs_;
+    std::vector<bool> contracted_;
+    std::vector<size_t> contracted_neighbors_;
+    SearchState state_;
+};
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        if (IsNegativeWeight(edge.weight)) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+        arcs_.push_back({edge.from, edge.to, edge.weight});
+    }
+    Contractor(*this).Run();
+    BuildUpwardArcs();
+}
+
+template <typename Weight>
+ContractionHierarchy<Weight>::ContractionHierarchy(const Graph& graph, Preprocessing preprocessing)
+    : graph_(graph)
+    , preprocessing_(std::move(preprocessing))
+{
+    if (preprocessing_.ranks.size() != graph.GetVertexCount()) {
+        throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        arcs_.push_back({edge.from, edge.to, edge.weight});
+    }
+    for (const Shortcut& shortcut : preprocessing_.shortcuts) {
+        if (shortcut.first >= arcs_.size() || shortcut.second >= arcs_.size()) {
+            throw std::invalid_argument("Contraction hierarchy doesn't match the graph");
+        }
+        arcs_.push_back({shortcut.from, shortcut.to, shortcut.weight});
+    }
+    BuildUpwardArcs();
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::BuildUpwardArcs() {
+    const auto& ranks = preprocessing_.ranks;
+    upward_arcs_.assign(graph_.GetVertexCount(), {});
+    downward_arcs_.assign(graph_.GetVertexCount(), {});
+    for (ArcId arc_id = 0; arc_id < arcs_.size(); ++arc_id) {
+        const Arc& arc = arcs_[arc_id];
+        if (ranks[arc.from] < ranks[arc.to]) {
+            upward_arcs_[arc.from].push_back(arc_id);
+        }
+        else if (ranks[arc.from] > ranks[arc.to]) {
+            downward_arcs_[arc.to].push_back(arc_id);
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchy<Weight>::UnpackArc(ArcId arc_id, std::vector<EdgeId>& edges) const {
+    const size_t edge_count = graph_.GetEdgeCount();
+    std::vector<ArcId> stack{arc_id};
+    while (!stack.empty()) {
+        const ArcId current = stack.back();
+        stack.pop_back();
+        if (current < edge_count) {
+            edges.push_back(current);
+            continue;
+        }
+        const Shortcut& shortcut = preprocessing_.shortcuts[current - edge_count];
+        stack.push_back(shortcut.second);
+        stack.push_back(shortcut.first);
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchy<Weight>::RouteInfo> ContractionHierarchy<Weight>::BuildRoute(VertexId from,
+                                                                                                         VertexId to,
+                                                                                                         const SearchLimits<Weight>& limits) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (limits.max_weight && IsNegativeWeight(*limits.max_weight)) {
+        return std::nullopt;
+    }
+    const Weight max_weight = limits.max_weight.value_or(std::numeric_limits<Weight>::max());
+    DeadlineCheck deadline_check(limits.deadline);
+
+    thread_local SearchState forward;
+    thread_local SearchState backward;
+    forward.Reset(vertex_count);
+    backward.Reset(vertex_count);
+    forward.Reach(from, ZERO_WEIGHT, NO_ARC);
+    backward.Reach(to, ZERO_WEIGHT, NO_ARC);
+
+    std::optional<Weight> best_weight;
+    VertexId meeting_vertex = from;
+
+    const auto step = [&](SearchState& state, const SearchState& other, bool is_forward) {
+        deadline_check.Step();
+        const auto [weight, vertex] = state.Pop();
+        if (state.weights[vertex] < weight) {
+            return;
+        }
+        if (other.IsReached(vertex) && (!best_weight || AddWeights(weight, other.weights[vertex]) < *best_weight)) {
+            best_weight = AddWeights(weight, other.weights[vertex]);
+            meeting_vertex = vertex;
+        }
+        const auto& arc_ids = is_forward ? upward_arcs_[vertex] : downward_arcs_[vertex];
+        for (const ArcId arc_id : arc_ids) {
+            const Arc& arc = arcs_[arc_id];
+            const VertexId next = is_forward ? arc.to : arc.from;
+            const Weight candidate_weight = AddWeights(weight, arc.weight);
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            if (!state.IsReached(next) || candidate_weight < state.weights[next]) {
+                state.Reach(next, candidate_weight, arc_id);
+            }
+        }
+    };
+    const auto is_done = [&](const SearchState& state) {
+        return state.queue.empty() || (best_weight && !(state.queue.front().first < *best_weight));
+    };
+
+    bool forward_turn = true;
+    while (!is_done(forward) || !is_done(backward)) {
+        if (is_done(backward) || (forward_turn && !is_done(forward))) {
+            step(forward, backward, true);
+        }
+        else {
+            step(backward, forward, false);
+        }
+        forward_turn = !forward_turn;
+    }
+
+    if (!best_weight || max_weight < *best_weight) {
+        return std::nullopt;
+    }
+
+    std::vector<ArcId> arc_path;
+    for (VertexId vertex = meeting_vertex; forward.prev_arcs[vertex] != NO_ARC; vertex = arcs_[forward.prev_arcs[vertex]].from) {
+        arc_path.push_back(forward.prev_arcs[vertex]);
+    }
+    std::reverse(arc_path.begin(), arc_path.end());
+    for (VertexId vertex = meeting_vertex; backward.prev_arcs[vertex] != NO_ARC; vertex = arcs_[backward.prev_arcs[vertex]].to) {
+        arc_path.push_back(backward.prev_arcs[vertex]);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const ArcId arc_id : arc_path) {
+        UnpackArc(arc_id, edges);
+    }
+    return RouteInfo{*best_weight, std::move(edges)};
+}
+
+template <typename Weight>
+std::vector<std::vector<std::optional<Weight>>> ContractionHierarchy<Weight>::BuildWeightMatrix(
+    const std::vector<VertexId>& from, const std::vector<VertexId>& to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    for (const std::vector<VertexId>* vertices : {&from, &to}) {
+        for (const VertexId vertex : *vertices) {
+            if (vertex >= vertex_count) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+        }
+    }
+
+    struct BucketEntry {
+        VertexId vertex;
+        size_t target;
+        Weight weight;
+    };
+    thread_local SearchState state;
+    std::vector<BucketEntry> entries;
+    for (size_t target = 0; target < to.size(); ++target) {
+        state.Reset(vertex_count);
+        SearchUpward(state, to[target], false, [&](VertexId vertex, Weight weight) {
+            entries.push_back({vertex, target, weight});
+        });
+    }
+
+    std::vector<size_t> bucket_offsets(vertex_count + 1, 0);
+    for (const BucketEntry& entry : entries) {
+        ++bucket_offsets[entry.vertex + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        bucket_offsets[vertex + 1] += bucket_offsets[vertex];
+    }
+    std::vector<BucketEntry> buckets(entries.size());
+    {
+        std::vector<size_t> positions(bucket_offsets.begin(), bucket_offsets.end() - 1);
+        for (const BucketEntry& entry : entries) {
+            buckets[positions[entry.vertex]++] = entry;
+        }
+    }
+
+    std::vector<std::vector<std::optional<Weight>>> weights(from.size(), std::vector<std::optional<Weight>>(to.size()));
+    for (size_t source = 0; source < from.size(); ++source) {
+        std::vector<std::optional<Weight>>& row = weights[source];
+        state.Reset(vertex_count);
+        SearchUpward(state, from[source], true, [&](VertexId vertex, Weight weight) {
+            for (size_t i = bucket_offsets[vertex]; i < bucket_offsets[vertex + 1]; ++i) {
+                const BucketEntry& entry = buckets[i];
+                const Weight candidate_weight = AddWeights(weight, entry.weight);
+                if (!row[entry.target] || candidate_weight < *row[entry.target]) {
+                    row[entry.target] = candidate_weight;
+                }
+            }
+        });
+    }
+    return weights;
+}
+
+template <typename Weight>
+template <typename Visitor>
+void ContractionHierarchy<Weight>::SearchUpward(SearchState& state, VertexId start, bool is_forward,
+                                                const Visitor& visit) const {
+    state.Reach(start, ZERO_WEIGHT, NO_ARC);
+    while (!state.queue.empty()) {
+        const auto [weight, vertex] = state.Pop();
+        if (state.weights[vertex] < weight) {
+            continue;
+        }
+        visit(vertex, weight);
+        const auto& arc_ids = is_forward ? upward_arcs_[vertex] : downward_arcs_[vertex];
+        for (const ArcId arc_id : arc_ids) {
+            const Arc& arc = arcs_[arc_id];
+            const VertexId next = is_forward ? arc.to : arc.from;
+            const Weight candidate_weight = AddWeights(weight, arc.weight);
+            if (!state.IsReached(next) || candidate_weight < state.weights[next]) {
+                state.Reach(next, candidate_weight, arc_id);
+            }
+        }
+    }
+}
+
+}  // namespace graph
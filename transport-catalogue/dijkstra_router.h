@@ -0,0 +1,309 @@
+#pragma once
+
+/**
+ * @file dijkstra_router.h
+ * @brief This file contains the declaration of the DijkstraRouter class, a router without precomputation.
+ */
+
+#include "graph.h"
+#include "router.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+/**
+ * @class DijkstraRouter
+ * @brief Router answering every query with its own Dijkstra search.
+ * Construction costs O(E) and no table is kept, so memory grows linearly with the graph.
+ * Search buffers are kept per thread and reused between queries. The graph must be frozen; searches scan its CSR arrays.
+ * @tparam Weight The weight type of the graph.
+ */
+template <typename Weight>
+class DijkstraRouter {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using RouteInfo = typename Router<Weight>::RouteInfo;
+
+    explicit DijkstraRouter(const Graph& graph);
+
+    /**
+     * @brief Builds the route between two vertices.
+     * With a weight limit the vertices beyond it are never queued, so the search ends as soon as the frontier exceeds it.
+     * @param limits The bounds of the search.
+     * @return The route, or std::nullopt if the target is unreachable within the weight limit.
+     * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+     */
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to, const SearchLimits<Weight>& limits = {}) const;
+
+    /**
+     * @brief Builds the routes from one vertex to several vertices with a single search.
+     * The search stops once every target is settled, so its cost does not depend on the number of targets.
+     * @return The routes in the order of the targets.
+     */
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from, const std::vector<VertexId>& to) const;
+
+    /**
+     * @brief Computes the weights of the routes from one vertex to several vertices with a single search.
+     * Like BuildRoutes, but the routes are not reconstructed.
+     * @return The weights in the order of the targets, std::nullopt where a target is unreachable.
+     */
+    std::vector<std::optional<Weight>> BuildRouteWeights(VertexId from, const std::vector<VertexId>& to) const;
+
+    /**
+     * @brief Finds every vertex reachable from a vertex within a weight budget with a single bounded search.
+     * Vertices beyond the budget are never queued, so the search ends as soon as the frontier exceeds it.
+     * @return Pairs of vertex and route weight in order of non-decreasing weight, the starting vertex first.
+     */
+    std::vector<std::pair<VertexId, Weight>> BuildReachable(VertexId from, Weight max_weight) const;
+
+private:
+    using QueueItem = std::pair<Weight, VertexId>;
+
+    /**
+     * @struct SearchState
+     * @brief Scratch buffers of one search. A vertex entry is valid only if its stamp equals the current one,
+     * so the buffers are never cleared between queries.
+     */
+    struct SearchState {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> stamps;
+        std::vector<uint32_t> target_stamps;
+        std::vector<QueueItem> queue;
+        uint32_t stamp = 0;
+
+        void Reset(size_t vertex_count) {
+            if (stamps.size() < vertex_count) {
+                weights.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                stamps.resize(vertex_count, 0);
+                target_stamps.resize(vertex_count, 0);
+            }
+            queue.clear();
+            if (++stamp == 0) {
+                std::fill(stamps.begin(), stamps.end(), 0);
+                std::fill(target_stamps.begin(), target_stamps.end(), 0);
+                stamp = 1;
+            }
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return stamps[vertex] == stamp;
+        }
+
+        bool IsTarget(VertexId vertex) const {
+            return target_stamps[vertex] == stamp;
+        }
+
+        void MarkTarget(VertexId vertex) {
+            target_stamps[vertex] = stamp;
+        }
+
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            stamps[vertex] = stamp;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+            queue.emplace_back(weight, vertex);
+            std::push_heap(queue.begin(), queue.end(), std::greater<QueueItem>{});
+        }
+    };
+
+    static SearchState& GetSearchState(size_t vertex_count) {
+        thread_local SearchState state;
+        state.Reset(vertex_count);
+        return state;
+    }
+
+    void CheckVertex(VertexId vertex) const {
+        if (vertex >= graph_.GetVertexCount()) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+    }
+
+    /**
+     * @brief Marks the targets of a search and counts the distinct ones.
+     */
+    size_t MarkTargets(SearchState& state, const std::vector<VertexId>& to) const;
+
+    /**
+     * @brief Runs the search from a vertex until target_count marked targets are settled or nothing is left to settle.
+     */
+    void Search(SearchState& state, VertexId from, size_t target_count, const SearchLimits<Weight>& limits = {}) const;
+
+    /**
+     * @brief Reconstructs the route to a settled vertex from the search state.
+     */
+    std::optional<RouteInfo> ExtractRoute(const SearchState& state, VertexId to) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = std::numeric_limits<EdgeId>::max();
+    const Graph& graph_;
+    typename Graph::CsrView csr_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+    , csr_(graph.GetCsr())
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (IsNegativeWeight(graph.GetEdge(edge_id).weight)) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to,
+                                                                                             const SearchLimits<Weight>& limits) const {
+    CheckVertex(from);
+    CheckVertex(to);
+    if (limits.max_weight && IsNegativeWeight(*limits.max_weight)) {
+        return std::nullopt;
+    }
+
+    SearchState& state = GetSearchState(graph_.GetVertexCount());
+    state.MarkTarget(to);
+    Search(state, from, 1, limits);
+    return ExtractRoute(state, to);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(
+    VertexId from, const std::vector<VertexId>& to) const {
+    CheckVertex(from);
+
+    SearchState& state = GetSearchState(graph_.GetVertexCount());
+    Search(state, from, MarkTargets(state, to));
+
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(to.size());
+    for (const VertexId vertex : to) {
+        routes.push_back(ExtractRoute(state, vertex));
+    }
+    return routes;
+}
+
+template <typename Weight>
+std::vector<std::optional<Weight>> DijkstraRouter<Weight>::BuildRouteWeights(VertexId from,
+                                                                             const std::vector<VertexId>& to) const {
+    CheckVertex(from);
+
+    SearchState& state = GetSearchState(graph_.GetVertexCount());
+    Search(state, from, MarkTargets(state, to));
+
+    std::vector<std::optional<Weight>> weights;
+    weights.reserve(to.size());
+    for (const VertexId vertex : to) {
+        weights.push_back(state.IsReached(vertex) ? std::optional<Weight>(state.weights[vertex]) : std::nullopt);
+    }
+    return weights;
+}
+
+template <typename Weight>
+std::vector<std::pair<VertexId, Weight>> DijkstraRouter<Weight>::BuildReachable(VertexId from, Weight max_weight) const {
+    CheckVertex(from);
+
+    std::vector<std::pair<VertexId, Weight>> reachable;
+    if (IsNegativeWeight(max_weight)) {
+        return reachable;
+    }
+    SearchState& state = GetSearchState(graph_.GetVertexCount());
+    state.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    while (!state.queue.empty()) {
+        std::pop_heap(state.queue.begin(), state.queue.end(), std::greater<QueueItem>{});
+        const auto [weight, vertex] = state.queue.back();
+        state.queue.pop_back();
+        if (state.weights[vertex] < weight) {
+            continue;
+        }
+        reachable.emplace_back(vertex, weight);
+        for (EdgeId i = csr_.offsets[vertex]; i < csr_.offsets[vertex + 1]; ++i) {
+            const VertexId next = csr_.targets[i];
+            const Weight candidate_weight = AddWeights(weight, csr_.weights[i]);
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            if (!state.IsReached(next) || candidate_weight < state.weights[next]) {
+                state.Reach(next, candidate_weight, csr_.edge_ids[i]);
+            }
+        }
+    }
+    return reachable;
+}
+
+template <typename Weight>
+size_t DijkstraRouter<Weight>::MarkTargets(SearchState& state, const std::vector<VertexId>& to) const {
+    size_t target_count = 0;
+    for (const VertexId vertex : to) {
+        CheckVertex(vertex);
+        if (!state.IsTarget(vertex)) {
+            state.MarkTarget(vertex);
+            ++target_count;
+        }
+    }
+    return target_count;
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::Search(SearchState& state, VertexId from, size_t target_count, const SearchLimits<Weight>& limits) const {
+    state.Reach(from, ZERO_WEIGHT, NO_EDGE);
+
+    if (target_count == 0) {
+        return;
+    }
+    const Weight max_weight = limits.max_weight.value_or(std::numeric_limits<Weight>::max());
+    DeadlineCheck deadline_check(limits.deadline);
+    while (!state.queue.empty()) {
+        deadline_check.Step();
+        std::pop_heap(state.queue.begin(), state.queue.end(), std::greater<QueueItem>{});
+        const auto [weight, vertex] = state.queue.back();
+        state.queue.pop_back();
+        if (state.weights[vertex] < weight) {
+            continue;
+        }
+        if (state.IsTarget(vertex) && --target_count == 0) {
+            break;
+        }
+        for (EdgeId i = csr_.offsets[vertex]; i < csr_.offsets[vertex + 1]; ++i) {
+            const VertexId next = csr_.targets[i];
+            const Weight candidate_weight = AddWeights(weight, csr_.weights[i]);
+            if (max_weight < candidate_weight) {
+                continue;
+            }
+            if (!state.IsReached(next) || candidate_weight < state.weights[next]) {
+                state.Reach(next, candidate_weight, csr_.edge_ids[i]);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::ExtractRoute(const SearchState& state,
+                                                                                               VertexId to) const {
+    if (!state.IsReached(to)) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = state.prev_edges[to]; edge_id != NO_EDGE;
+         edge_id = state.prev_edges[graph_.GetEdge(edge_id).from])
+    {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{state.weights[to], std::move(edges)};
+}
+
+}  // namespace graph
@@ -7,6 +7,7 @@
 
 #include "geo.h"
 
+#include <cstdint>
 #include <string>
 #include <vector>
 #include "deque"
@@ -26,6 +27,7 @@ namespace domain {
 	struct Stop {
 		std::string stop_name;
 		geo::Coordinates coordinates;
+		uint32_t id = 0;	/**< The position of the stop in TransportCatalogue::GetStops(), set by AddStop */
 
 	};
 
@@ -52,14 +54,40 @@ namespace domain {
 	};
 
 
+	/**
+	 * @struct RoutePrefixSums
+	 * @brief Struct holding the prefix sums of the distances along one direction of a bus.
+	 * Element i is the distance from the first stop of the direction to its i-th stop,
+	 * so the length of any segment is a subtraction.
+	 */
+	struct RoutePrefixSums {
+		std::vector<int64_t> road_distances;	/**< The road distances in meters */
+		std::vector<double> geo_distances;	/**< The geographic distances in meters */
+	};
+
 	/**
 	 * @struct Bus
 	 * @brief Struct representing a bus with a bus name, list of stops, and type.
 	 */
 	struct Bus {
 		std::string bus_name;
+		uint32_t id = 0;	/**< The position of the bus in TransportCatalogue::GetBuses(), set by AddBus */
 		std::deque<std::string_view> stops;
 		std::string type;
+		RoutePrefixSums forward;	/**< The prefix sums in the order of stops, set by AddBus */
+		RoutePrefixSums backward;	/**< The prefix sums in the reverse order of stops, set by AddBus for non-roundtrip buses */
+	};
+
+	/**
+	 * @enum RouterEngine
+	 * @brief Enum listing the algorithms available for answering route requests.
+	 */
+	enum class RouterEngine {
+		ALL_PAIRS,	/**< Shortest paths between all vertices are precomputed */
+		DIJKSTRA,	/**< Every request runs its own search, nothing is precomputed */
+		CONTRACTION_HIERARCHIES,	/**< Shortcuts are precomputed, every request runs a bidirectional upward search */
+		ALT,	/**< Landmark distances are precomputed, every request runs an A* search guided by them */
+		RAPTOR	/**< No graph is built, every request runs a round-based scan of the bus routes */
 	};
 
 	/**
@@ -69,6 +97,7 @@ namespace domain {
 	struct RouteSettings {
 		double bus_velocity;
 		double bus_wait_time;
+		RouterEngine router_engine = RouterEngine::ALL_PAIRS;
 
 	};
 
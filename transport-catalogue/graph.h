@@ -3,7 +3,13 @@
 #include "ranges.h"
 #include "transport_catalogue.h"
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
 #include <vector>
 #include <unordered_map>
 #include <iostream>
@@ -14,18 +20,102 @@ namespace graph {
     using VertexId = size_t;
     using EdgeId = size_t;
 
+    /**
+     * @brief Adds two weights. Integer weights saturate at their maximum, which the routers use as the unreachable weight,
+     * so a sum with an unreachable weight stays unreachable instead of wrapping around.
+     * @tparam Weight The weight type.
+     * @return The sum of the weights.
+     */
+    template <typename Weight>
+    constexpr Weight AddWeights(Weight lhs, Weight rhs) {
+        if constexpr (std::is_integral_v<Weight>) {
+            Weight sum;
+            return __builtin_add_overflow(lhs, rhs, &sum) ? std::numeric_limits<Weight>::max() : sum;
+        }
+        else {
+            return lhs + rhs;
+        }
+    }
+
+    /**
+     * @brief Checks whether a weight is negative; an unsigned weight never is.
+     * @tparam Weight The weight type.
+     */
+    template <typename Weight>
+    constexpr bool IsNegativeWeight(Weight weight) {
+        if constexpr (std::is_unsigned_v<Weight>) {
+            return false;
+        }
+        else {
+            return weight < Weight{};
+        }
+    }
+
+    /**
+     * @class SearchTimeoutError
+     * @brief Exception thrown by a route search that runs past its deadline.
+     */
+    class SearchTimeoutError : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * @struct SearchLimits
+     * @brief Struct representing the bounds of one route search; the default limits bound nothing.
+     * @tparam Weight The weight type.
+     */
+    template <typename Weight>
+    struct SearchLimits {
+        std::optional<Weight> max_weight; /**< Heavier routes are not looked for: the search stops once its frontier exceeds this */
+        std::optional<std::chrono::steady_clock::time_point> deadline; /**< The instant after which the search throws SearchTimeoutError */
+    };
+
+    /**
+     * @class DeadlineCheck
+     * @brief Class counting the steps of a search and reading the clock only every STEP_INTERVAL steps.
+     * A search without a deadline pays a single branch per step.
+     */
+    class DeadlineCheck {
+    public:
+        explicit DeadlineCheck(std::optional<std::chrono::steady_clock::time_point> deadline)
+            : deadline_(deadline) {
+        }
+
+        /**
+         * @brief Counts a step of the search.
+         * @throws SearchTimeoutError if the deadline has passed.
+         */
+        void Step() {
+            if (deadline_ && ++step_count_ % STEP_INTERVAL == 0 && *deadline_ < std::chrono::steady_clock::now()) {
+                throw SearchTimeoutError("Route search exceeded its deadline");
+            }
+        }
+
+    private:
+        static constexpr uint32_t STEP_INTERVAL = 256;
+        std::optional<std::chrono::steady_clock::time_point> deadline_;
+        uint32_t step_count_ = 0;
+    };
+
     /**
      * @struct Edge
      * @brief Struct representing an edge in a directed weighted graph.
+     * The vertices and the road distance take 32 bits each and the bus id and span share 32 bits,
+     * so an edge with double weight takes 24 bytes.
      * @tparam Weight The weight type of the edge.
      */
     template <typename Weight>
     struct Edge {
-        VertexId from;   /**< The source vertex of the edge. */
-        VertexId to;     /**< The target vertex of the edge. */
+        static constexpr uint32_t MAX_NAME_ID = (1u << 20) - 1;    /**< The largest bus id an edge can hold. */
+        static constexpr uint32_t MAX_SPAN_COUNT = (1u << 12) - 1; /**< The largest number of stops an edge can span. */
+
+        uint32_t from;   /**< The source vertex of the edge. */
+        uint32_t to;     /**< The target vertex of the edge. */
         Weight weight;   /**< The weight of the edge. */
-        std::string name;   /**< The name of the edge. */
-        int stop_count; /**< The number of stops in the edge. */
+        uint32_t name_id : 20;    /**< The catalogue id of the bus riding the edge. */
+        uint32_t span_count : 12; /**< The number of stops spanned by the edge. */
+        uint32_t distance;        /**< The road distance covered by the edge in meters, from which the weight is derived. */
 
         /**
          * @brief Overloaded equality operator for comparing edges.
@@ -58,18 +148,62 @@ namespace graph {
             const Edge<Weight>& GetEdge(EdgeId edge_id) const;
             IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+            /**
+             * @struct CsrView
+             * @brief The edges of a frozen graph in compressed sparse row form.
+             * The edges leaving vertex v occupy the positions [offsets[v], offsets[v + 1]) of the other arrays.
+             */
+            struct CsrView {
+                const EdgeId* offsets;      /**< vertex_count + 1 offsets */
+                const uint32_t* targets;    /**< The target vertex of every edge */
+                const Weight* weights;      /**< The weight of every edge */
+                const EdgeId* edge_ids;     /**< The id of every edge, as returned by AddEdge */
+            };
+
+            /**
+             * @brief Packs the edges into contiguous arrays sorted by source and drops the incidence lists.
+             * Edge ids and the order of the edges of a vertex are kept. The graph cannot be changed afterwards.
+             */
+            void Freeze();
+            bool IsFrozen() const;
+
+            /**
+             * @brief Retrieves the compressed sparse row arrays of a frozen graph.
+             * @throws std::logic_error if the graph is not frozen.
+             */
+            CsrView GetCsr() const;
+
+            /**
+             * @brief Recomputes the weight of every edge in linear time, keeping the edge ids and the frozen layout.
+             * The routers built over the graph see the new weights, but their precomputed data goes stale.
+             * @param compute_weight The function returning the new weight of an edge.
+             */
+            template <typename ComputeWeight>
+            void Reweight(ComputeWeight compute_weight);
+
         private:
             std::vector<Edge<Weight>> edges_;
             std::vector<IncidenceList> incidence_lists_;
+            bool frozen_ = false;
+            std::vector<EdgeId> csr_offsets_;
+            std::vector<uint32_t> csr_targets_;
+            std::vector<Weight> csr_weights_;
+            std::vector<EdgeId> csr_edge_ids_;
     };
 
     template <typename Weight>
     DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
         : incidence_lists_(vertex_count) {
+        if (vertex_count > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("Too many vertices for 32-bit edges");
+        }
     }
 
     template <typename Weight>
     EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+        if (frozen_) {
+            throw std::logic_error("Frozen graph cannot be changed");
+        }
         edges_.push_back(edge);
         const EdgeId id = edges_.size() - 1;
         incidence_lists_.at(edge.from).push_back(id); 
@@ -78,7 +212,7 @@ namespace graph {
 
     template <typename Weight>
     size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-        return incidence_lists_.size();
+        return frozen_ ? csr_offsets_.size() - 1 : incidence_lists_.size();
     }
 
     template <typename Weight>
@@ -94,9 +228,104 @@ namespace graph {
     template <typename Weight>
     typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
         DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+        if (frozen_) {
+            if (vertex >= GetVertexCount()) {
+                throw std::out_of_range("Vertex id is out of range");
+            }
+            return {csr_edge_ids_.begin() + csr_offsets_[vertex], csr_edge_ids_.begin() + csr_offsets_[vertex + 1]};
+        }
         return ranges::AsRange(incidence_lists_.at(vertex));
     }
 
+    template <typename Weight>
+    void DirectedWeightedGraph<Weight>::Freeze() {
+        if (frozen_) {
+            return;
+        }
+        csr_offsets_.reserve(incidence_lists_.size() + 1);
+        csr_offsets_.push_back(0);
+        csr_targets_.reserve(edges_.size());
+        csr_weights_.reserve(edges_.size());
+        csr_edge_ids_.reserve(edges_.size());
+        for (const IncidenceList& incidence_list : incidence_lists_) {
+            for (const EdgeId edge_id : incidence_list) {
+                csr_targets_.push_back(edges_[edge_id].to);
+                csr_weights_.push_back(edges_[edge_id].weight);
+                csr_edge_ids_.push_back(edge_id);
+            }
+            csr_offsets_.push_back(csr_edge_ids_.size());
+        }
+        incidence_lists_ = {};
+        frozen_ = true;
+    }
+
+    template <typename Weight>
+    template <typename ComputeWeight>
+    void DirectedWeightedGraph<Weight>::Reweight(ComputeWeight compute_weight) {
+        for (Edge<Weight>& edge : edges_) {
+            edge.weight = compute_weight(static_cast<const Edge<Weight>&>(edge));
+        }
+        for (size_t i = 0; i < csr_edge_ids_.size(); ++i) {
+            csr_weights_[i] = edges_[csr_edge_ids_[i]].weight;
+        }
+    }
+
+    template <typename Weight>
+    bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+        return frozen_;
+    }
+
+    template <typename Weight>
+    typename DirectedWeightedGraph<Weight>::CsrView DirectedWeightedGraph<Weight>::GetCsr() const {
+        if (!frozen_) {
+            throw std::logic_error("Graph should be frozen");
+        }
+        return {csr_offsets_.data(), csr_targets_.data(), csr_weights_.data(), csr_edge_ids_.data()};
+    }
+
+    /**
+     * @brief Labels the weakly connected components of a graph.
+     * Two vertices share a label if a chain of edges joins them when the directions are ignored,
+     * so no route leads from one component to another. The components are numbered in the order of their smallest vertex.
+     * @param graph The graph.
+     * @return The component of every vertex.
+     */
+    template <typename Weight>
+    std::vector<uint32_t> ComputeWeakComponents(const DirectedWeightedGraph<Weight>& graph) {
+        const size_t vertex_count = graph.GetVertexCount();
+        std::vector<VertexId> parents(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            parents[vertex] = vertex;
+        }
+        const auto find_root = [&parents](VertexId vertex) {
+            while (parents[vertex] != vertex) {
+                parents[vertex] = parents[parents[vertex]];
+                vertex = parents[vertex];
+            }
+            return vertex;
+        };
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const Edge<Weight>& edge = graph.GetEdge(edge_id);
+            const VertexId from_root = find_root(edge.from);
+            const VertexId to_root = find_root(edge.to);
+            if (from_root < to_root) {
+                parents[to_root] = from_root;
+            }
+            else if (to_root < from_root) {
+                parents[from_root] = to_root;
+            }
+        }
+
+        // Every root is the smallest vertex of its set, so it is labelled before the other vertices of the set.
+        std::vector<uint32_t> components(vertex_count);
+        uint32_t component_count = 0;
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const VertexId root = find_root(vertex);
+            components[vertex] = root == vertex ? component_count++ : components[root];
+        }
+        return components;
+    }
+
 
 
 }  // namespace graph  
\ No newline at end of file
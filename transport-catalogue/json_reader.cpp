@@ -64,8 +64,15 @@ namespace transport_catalogue {
 	 * @brief Reads the base requests from the JSON input.
 	 */
 	void InputReaderJson::ReadInputJsonBaseRequest() {
-		const auto& json_array = ((load_.GetRoot()).AsDict()).at("base_requests"s);
-		for (const auto& file : json_array.AsArray()) {
+		ReadBaseRequests(((load_.GetRoot()).AsDict()).at("base_requests"s).AsArray());
+	}
+
+	/**
+	 * @brief Reads Stop and Bus base requests into the pending catalogue updates.
+	 * @param requests The base requests.
+	 */
+	void InputReaderJson::ReadBaseRequests(const json::Array& requests) {
+		for (const auto& file : requests) {
 			const auto& json_obj = file.AsDict();
 			if (json_obj.at("type"s) == "Stop"s) {
 				Stop stopjson;
@@ -126,9 +133,43 @@ namespace transport_catalogue {
 					outputstopjson.type = json_obj.at("type").AsString();
 					outputstopjson.from = json_obj.at("from").AsString();
 					outputstopjson.to = json_obj.at("to").AsString();
+					if (auto it = json_obj.find("avoid_stops"s); it != json_obj.end()) {
+						for (const auto& stop : it->second.AsArray()) {
+							outputstopjson.avoid_stops.push_back(stop.AsString());
+						}
+					}
+					if (auto it = json_obj.find("avoid_buses"s); it != json_obj.end()) {
+						for (const auto& bus : it->second.AsArray()) {
+							outputstopjson.avoid_buses.push_back(bus.AsString());
+						}
+					}
+					if (auto it = json_obj.find("max_total_time"s); it != json_obj.end()) {
+						outputstopjson.max_total_time = it->second.AsDouble();
+					}
+					if (auto it = json_obj.find("compute_budget_ms"s); it != json_obj.end()) {
+						outputstopjson.compute_budget_ms = it->second.AsDouble();
+					}
 
 					output_requests_.push_back(outputstopjson);
-				} 
+				}
+				else if (json_obj.at("type").AsString() == "Reachable"s) {
+					outputstopjson.id = json_obj.at("id").AsInt();
+					outputstopjson.type = json_obj.at("type").AsString();
+					outputstopjson.from = json_obj.at("from").AsString();
+					outputstopjson.max_time = json_obj.at("max_time").AsDouble();
+					output_requests_.push_back(outputstopjson);
+				}
+				else if (json_obj.at("type").AsString() == "RouteMatrix"s) {
+					outputstopjson.id = json_obj.at("id").AsInt();
+					outputstopjson.type = json_obj.at("type").AsString();
+					for (const auto& stop : json_obj.at("from").AsArray()) {
+						outputstopjson.from_stops.push_back(stop.AsString());
+					}
+					for (const auto& stop : json_obj.at("to").AsArray()) {
+						outputstopjson.to_stops.push_back(stop.AsString());
+					}
+					output_requests_.push_back(outputstopjson);
+				}
 				else {
 					outputstopjson.name = json_obj.at("name").AsString();
 					outputstopjson.id = json_obj.at("id").AsInt();
@@ -216,6 +257,27 @@ namespace transport_catalogue {
 		const auto& json_obj = json_array_out.AsDict();
 		route_settings_.bus_velocity = json_obj.at("bus_velocity").AsDouble();
 		route_settings_.bus_wait_time = json_obj.at("bus_wait_time").AsDouble();
+		if (json_obj.find("router") != json_obj.end()) {
+			const std::string& router = json_obj.at("router").AsString();
+			if (router == "all_pairs"s) {
+				route_settings_.router_engine = RouterEngine::ALL_PAIRS;
+			}
+			else if (router == "dijkstra"s) {
+				route_settings_.router_engine = RouterEngine::DIJKSTRA;
+			}
+			else if (router == "contraction_hierarchies"s) {
+				route_settings_.router_engine = RouterEngine::CONTRACTION_HIERARCHIES;
+			}
+			else if (router == "alt"s) {
+				route_settings_.router_engine = RouterEngine::ALT;
+			}
+			else if (router == "raptor"s) {
+				route_settings_.router_engine = RouterEngine::RAPTOR;
+			}
+			else {
+				throw std::invalid_argument("unknown router: "s + router);
+			}
+		}
 	}
 
 	/**
@@ -225,6 +287,71 @@ namespace transport_catalogue {
 		const auto& json_array_out = ((load_.GetRoot()).AsDict()).at("serialization_settings"s);
 		const auto& json_obj = json_array_out.AsDict();
 		serialize_file_path_ = json_obj.at("file").AsString();
+		if (json_obj.find("router_table_file") != json_obj.end()) {
+			router_table_file_path_ = json_obj.at("router_table_file").AsString();
+		}
+		if (json_obj.find("router_table_advice") != json_obj.end()) {
+			const std::string& advice = json_obj.at("router_table_advice").AsString();
+			if (advice == "normal"s) {
+				router_table_advice_ = graph::MapAdvice::NORMAL;
+			}
+			else if (advice == "random"s) {
+				router_table_advice_ = graph::MapAdvice::RANDOM;
+			}
+			else if (advice == "sequential"s) {
+				router_table_advice_ = graph::MapAdvice::SEQUENTIAL;
+			}
+			else if (advice == "will_need"s) {
+				router_table_advice_ = graph::MapAdvice::WILL_NEED;
+			}
+			else {
+				throw std::invalid_argument("unknown router table advice: "s + advice);
+			}
+		}
+	}
+
+	/**
+	 * @brief Reads the optional stat settings from the JSON input.
+	 */
+	void InputReaderJson::ReadInputJsonStatSettings() {
+		const auto& root = (load_.GetRoot()).AsDict();
+		if (root.find("stat_settings"s) == root.end()) {
+			return;
+		}
+		const auto& json_obj = root.at("stat_settings"s).AsDict();
+		if (json_obj.find("batch_routes") != json_obj.end()) {
+			stat_settings_.batch_routes = json_obj.at("batch_routes").AsBool();
+		}
+		if (json_obj.find("route_cache_size") != json_obj.end()) {
+			const int route_cache_size = json_obj.at("route_cache_size").AsInt();
+			if (route_cache_size < 0) {
+				throw std::invalid_argument("route_cache_size must not be negative"s);
+			}
+			stat_settings_.route_cache_size = static_cast<size_t>(route_cache_size);
+		}
+	}
+
+	/**
+	 * @brief Reads the optional bus updates of a loaded base from the JSON input.
+	 * The new stops and buses are given as base requests; the buses to remove by name.
+	 */
+	void InputReaderJson::ReadInputJsonBusUpdates() {
+		const auto& root = (load_.GetRoot()).AsDict();
+		if (root.find("bus_updates"s) == root.end()) {
+			return;
+		}
+		const auto& json_obj = root.at("bus_updates"s).AsDict();
+		if (json_obj.find("base_requests") != json_obj.end()) {
+			ReadBaseRequests(json_obj.at("base_requests").AsArray());
+			for (const domain::BusDescription& bus : update_requests_bus_) {
+				bus_updates_.added_buses.push_back(bus.bus_name);
+			}
+		}
+		if (json_obj.find("remove_buses") != json_obj.end()) {
+			for (const auto& bus : json_obj.at("remove_buses").AsArray()) {
+				bus_updates_.removed_buses.push_back(bus.AsString());
+			}
+		}
 	}
 
 	/**
@@ -249,12 +376,97 @@ namespace transport_catalogue {
 
 	/**
 	 * @brief Reads the request information for reading the base from the JSON input.
+	 * The routing settings are optional here: when given, they override the wait time and velocity of the base.
+	 * So are the bus updates, applied to the loaded base before the stat requests are answered.
 	 */
 	void InputReaderJson::ReadInputJsonRequestForReadBase() {
+		const auto& root = (load_.GetRoot()).AsDict();
+		if (root.find("routing_settings"s) != root.end()) {
+			ReadInputJsonRouteSettings();
+			has_route_settings_ = true;
+		}
 		ReadInputJsonSerializeSettings();
+		ReadInputJsonStatSettings();
+		ReadInputJsonBusUpdates();
 		ReadInputJsonStatRequest();
 	}
 
+	/**
+	 * @brief Collects the restrictions of a Route request.
+	 * @param request The request.
+	 * @return The restrictions, referring to the names held by the request.
+	 */
+	graph::RouteRestrictions InputReaderJson::MakeRouteRestrictions(const OutputRequest& request) {
+		graph::RouteRestrictions restrictions;
+		restrictions.avoid_stops.assign(request.avoid_stops.begin(), request.avoid_stops.end());
+		restrictions.avoid_buses.assign(request.avoid_buses.begin(), request.avoid_buses.end());
+		restrictions.max_time = request.max_total_time;
+		if (request.compute_budget_ms) {
+			restrictions.compute_budget = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double, std::milli>(*request.compute_budget_ms));
+		}
+		return restrictions;
+	}
+
+	/**
+	 * @brief Converts the activities of a route to the items of its response.
+	 * @param route The route.
+	 * @return The response items in travel order.
+	 */
+	json::Array InputReaderJson::MakeRouteItems(const graph::DestinationInfo& route) {
+		json::Array items;
+		items.reserve(route.route.size());
+		for (const auto& activity : route.route) {
+			json::Dict item;
+			if (const graph::BusActivity* bus = std::get_if<graph::BusActivity>(&activity)) {
+				item.emplace("bus"s, std::string(bus->bus_name));
+				item.emplace("span_count"s, bus->span_count);
+				item.emplace("time"s, bus->time);
+				item.emplace("type"s, "Bus"s);
+			}
+			else {
+				const graph::WaitingActivity& wait = std::get<graph::WaitingActivity>(activity);
+				item.emplace("stop_name"s, std::string(wait.stop_name_from));
+				item.emplace("time"s, wait.time);
+				item.emplace("type"s, "Wait"s);
+			}
+			items.emplace_back(std::move(item));
+		}
+		return items;
+	}
+
+	/**
+	 * @brief Answers all the Route requests grouped by their starting stop.
+	 * @param tc The transport catalogue.
+	 * @param router The transport router.
+	 * @return The routes indexed like output_requests_; std::nullopt for other requests and missing routes.
+	 */
+	std::vector<std::optional<graph::DestinationInfo>> InputReaderJson::ComputeBatchedRoutes(TransportCatalogue& tc, graph::TransportRouter& router) const {
+		std::vector<std::optional<graph::DestinationInfo>> routes(output_requests_.size());
+
+		std::map<std::string_view, std::vector<size_t>> requests_by_from;
+		for (size_t i = 0; i < output_requests_.size(); ++i) {
+			const OutputRequest& request = output_requests_[i];
+			if (request.type == "Route"s && MakeRouteRestrictions(request).IsEmpty()
+				&& tc.FindStop(request.from) && tc.FindStop(request.to)) {
+				requests_by_from[request.from].push_back(i);
+			}
+		}
+
+		for (const auto& [from, request_indexes] : requests_by_from) {
+			std::vector<std::string_view> to;
+			to.reserve(request_indexes.size());
+			for (size_t i : request_indexes) {
+				to.push_back(output_requests_[i].to);
+			}
+			std::vector<std::optional<graph::DestinationInfo>> destinations = router.GetRoutesAndBuses(from, to);
+			for (size_t j = 0; j < request_indexes.size(); ++j) {
+				routes[request_indexes[j]] = std::move(destinations[j]);
+			}
+		}
+		return routes;
+	}
+
 	/**
 	 * @brief Updates the stop data in the transport catalogue.
 	 * @param tc The transport catalogue to update.
@@ -285,6 +497,28 @@ namespace transport_catalogue {
 		}
 	}
 
+	/**
+	 * @brief Adds the stops, distances and buses of the bus updates to the catalogue of a loaded base.
+	 * Only new stops and buses are accepted, so the distances and rides already routed stay as they are.
+	 * @param tc The transport catalogue to update.
+	 * @throws std::invalid_argument if a stop or a bus of the updates is already in the catalogue.
+	 */
+	void InputReaderJson::UpdBusUpdates(TransportCatalogue& tc) {
+		for (const domain::Stop& stop : update_requests_stop_) {
+			if (tc.FindStop(stop.stop_name) != nullptr) {
+				throw std::invalid_argument("bus updates: stop "s + stop.stop_name + " is already in the base"s);
+			}
+		}
+		for (const domain::BusDescription& bus : update_requests_bus_) {
+			if (tc.FindBus(bus.bus_name) != nullptr) {
+				throw std::invalid_argument("bus updates: bus "s + bus.bus_name + " is already in the base"s);
+			}
+		}
+		UpdStop(tc);
+		UpdStopDist(tc);
+		UpdBus(tc);
+	}
+
 	/**
 	 * @brief Returns the render data read from the JSON input.
 	 * @return The render data.
@@ -317,4 +551,47 @@ namespace transport_catalogue {
 	std::string InputReaderJson::GetSerializeFilePath() {
 		return serialize_file_path_;
 	}
+
+	/**
+	 * @brief Returns the path of the separate routes table file.
+	 * @return The file path, or an empty string if the table is kept inside the base.
+	 */
+	std::string InputReaderJson::GetRouterTableFilePath() {
+		return router_table_file_path_;
+	}
+
+	/**
+	 * @brief Returns the hint for mapping the routes table file.
+	 * @return The map advice.
+	 */
+	graph::MapAdvice InputReaderJson::GetRouterTableAdvice() {
+		return router_table_advice_;
+	}
+
+	/**
+	 * @brief Returns the routing settings read along with the stat requests.
+	 * @return The route settings, or std::nullopt if the input has none.
+	 */
+	std::optional<domain::RouteSettings> InputReaderJson::GetRouteSettings() const {
+		if (!has_route_settings_) {
+			return std::nullopt;
+		}
+		return route_settings_;
+	}
+
+	/**
+	 * @brief Returns the settings for answering the stat requests.
+	 * @return The stat settings.
+	 */
+	StatSettings InputReaderJson::GetStatSettings() {
+		return stat_settings_;
+	}
+
+	/**
+	 * @brief Returns the bus updates of the loaded base.
+	 * @return The bus updates; empty if the input gives none.
+	 */
+	BusUpdates InputReaderJson::GetBusUpdates() const {
+		return bus_updates_;
+	}
 }  // namespace transport_catalogue
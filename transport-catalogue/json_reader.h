@@ -7,8 +7,10 @@
 
 #include <sstream>
 #include <string>
+#include <chrono>
 #include <deque>
 #include <iostream>
+#include <optional>
 #include <vector>
 
 #include "transport_catalogue.h"
@@ -39,6 +41,24 @@ inline std::string Print(const json::Node& node) {
 
 namespace transport_catalogue {
 
+    /**
+     * @struct StatSettings
+     * @brief Struct representing the settings for answering the stat requests.
+     */
+    struct StatSettings {
+        bool batch_routes = false; /**< Route requests with the same origin are answered from one search */
+        size_t route_cache_size = 0; /**< The capacity of the route cache, zero to disable it */
+    };
+
+    /**
+     * @struct BusUpdates
+     * @brief Struct representing the buses to add to or remove from the routes of a loaded base.
+     */
+    struct BusUpdates {
+        std::vector<std::string> added_buses; /**< The buses of the update's base requests, routed once they are in the catalogue */
+        std::vector<std::string> removed_buses; /**< The buses of the base no longer routed; they stay in the catalogue */
+    };
+
     /**
      * @class InputReaderJson
      * @brief Class for reading input data from JSON format.
@@ -58,6 +78,8 @@ namespace transport_catalogue {
 
 			void ReadInputJsonRouteSettings();
 			void ReadInputJsonSerializeSettings();
+			void ReadInputJsonStatSettings();
+			void ReadInputJsonBusUpdates();
 
             void ReadInputJsonRequest();
 
@@ -82,6 +104,13 @@ namespace transport_catalogue {
              */
             void UpdStopDist(TransportCatalogue& tc);
 
+            /**
+             * @brief Adds the stops, distances and buses of the bus updates to the catalogue of a loaded base.
+             * @param tc The transport catalogue to update.
+             * @throws std::invalid_argument if a stop or a bus of the updates is already in the catalogue.
+             */
+            void UpdBusUpdates(TransportCatalogue& tc);
+
 
 			/**
 			 * @brief Manages the output requests for the transport catalogue and map renderer.
@@ -95,7 +124,12 @@ namespace transport_catalogue {
 			void ManageOutputRequests(TransportCatalogue& tc, MapRenderer& mr, graph::TransportRouter& actprocess) {
 				std::ostream& out = std::cout;
 				json::Array queries;
-				for (const auto& el : output_requests_) {
+				std::vector<std::optional<graph::DestinationInfo>> batched_routes;
+				if (stat_settings_.batch_routes) {
+					batched_routes = ComputeBatchedRoutes(tc, actprocess);
+				}
+				for (size_t request_index = 0; request_index < output_requests_.size(); ++request_index) {
+					const auto& el = output_requests_[request_index];
 					if (el.type == "Bus"s) {
 
 						const Bus* bus_resp = tc.FindBus(el.name);
@@ -182,61 +216,33 @@ namespace transport_catalogue {
 
 						if (tc.FindStop(el.from) && tc.FindStop(el.to)) {
 
-							std::optional<graph::DestinationInfo> route = actprocess.GetRouteAndBuses(el.from, el.to);
-							std::vector<json::Node> array;
-
-							int request_id = el.id;
-							double total_time = 0;
+							const graph::RouteRestrictions restrictions = MakeRouteRestrictions(el);
+							std::optional<graph::DestinationInfo> route;
 							std::string error_message = "not found"s;
-		
-							if (route.has_value()) {
-								total_time = route.value().all_time;
-								std::vector<std::variant<graph::BusActivity, graph::WaitingActivity>> final_route = route.value().route;
-
-								for (auto el : final_route) {
-
-									if (std::holds_alternative<graph::BusActivity>(el)) {
-										graph::BusActivity act = std::get<graph::BusActivity>(el);
-
-										json::Node bus_route_description = json::Builder{}
-											.StartDict()
-											.Key("bus").Value(act.bus_name)
-											.Key("span_count").Value(act.span_count)
-											.Key("time").Value(act.time)
-											.Key("type").Value("Bus")
-											.EndDict().Build();
-
-										array.push_back(bus_route_description);
-									}
-
-									else {
-										graph::WaitingActivity act = std::get<graph::WaitingActivity>(el);
-
-										json::Node bus_route_description = json::Builder{}
-											.StartDict()
-											.Key("stop_name").Value(act.stop_name_from)
-											.Key("time").Value(act.time)
-											.Key("type").Value("Wait")
-											.EndDict().Build();
-
-										array.push_back(bus_route_description);
-
-									}
-
+							if (!restrictions.IsEmpty()) {
+								try {
+									route = actprocess.GetRouteAndBuses(el.from, el.to, restrictions);
 								}
-								json::Node final_route_description = json::Builder{}
-									.StartDict()
-									.Key("items").Value(array)
-									.Key("request_id").Value(request_id)
-									.Key("total_time").Value(total_time)
-									.EndDict().Build();
-
-								queries.emplace_back(final_route_description);
+								catch (const graph::SearchTimeoutError&) {
+									error_message = "timed out"s;
+								}
+							}
+							else if (stat_settings_.batch_routes) {
+								route = std::move(batched_routes[request_index]);
+							}
+							else {
+								route = actprocess.GetRouteAndBuses(el.from, el.to);
+							}
+							int request_id = el.id;
 
+							if (route.has_value()) {
+								json::Dict final_route_description;
+								final_route_description.emplace("items"s, MakeRouteItems(*route));
+								final_route_description.emplace("request_id"s, request_id);
+								final_route_description.emplace("total_time"s, route->all_time);
+								queries.emplace_back(std::move(final_route_description));
 							}
 							else {
-								int request_id = el.id;
-								std::string error_message = "not found"s;
 								json::Node final_route_description = json::Builder{}
 									.StartDict()
 									.Key("request_id").Value(request_id)
@@ -259,6 +265,62 @@ namespace transport_catalogue {
 						}
 
 					}
+					else if (el.type == "RouteMatrix"s) {
+						const std::vector<std::string_view> from(el.from_stops.begin(), el.from_stops.end());
+						const std::vector<std::string_view> to(el.to_stops.begin(), el.to_stops.end());
+						const std::vector<std::vector<std::optional<double>>> matrix = actprocess.GetRouteMatrix(from, to);
+
+						json::Array rows;
+						rows.reserve(matrix.size());
+						for (const auto& matrix_row : matrix) {
+							json::Array row;
+							row.reserve(matrix_row.size());
+							for (const std::optional<double>& total_time : matrix_row) {
+								row.push_back(total_time ? json::Node(*total_time) : json::Node(nullptr));
+							}
+							rows.push_back(std::move(row));
+						}
+
+						json::Node route_matrix = json::Builder{}
+							.StartDict()
+							.Key("request_id").Value(el.id)
+							.Key("total_time").Value(std::move(rows))
+							.EndDict().Build();
+						queries.emplace_back(route_matrix);
+					}
+					else if (el.type == "Reachable"s) {
+						std::optional<std::vector<graph::ReachableStop>> reachable_stops;
+						if (tc.FindStop(el.from)) {
+							reachable_stops = actprocess.GetReachableStops(el.from, el.max_time);
+						}
+
+						if (reachable_stops) {
+							json::Array stops;
+							stops.reserve(reachable_stops->size());
+							for (const graph::ReachableStop& stop : *reachable_stops) {
+								stops.push_back(json::Builder{}
+									.StartDict()
+									.Key("stop_name").Value(std::string(stop.stop_name))
+									.Key("time").Value(stop.time)
+									.EndDict().Build());
+							}
+
+							json::Node reachable = json::Builder{}
+								.StartDict()
+								.Key("request_id").Value(el.id)
+								.Key("stops").Value(std::move(stops))
+								.EndDict().Build();
+							queries.emplace_back(reachable);
+						}
+						else {
+							json::Node reachable = json::Builder{}
+								.StartDict()
+								.Key("request_id").Value(el.id)
+								.Key("error_message").Value("not found"s)
+								.EndDict().Build();
+							queries.emplace_back(reachable);
+						}
+					}
 				}
 				json::Print(json::Document{ queries }, out);
 			}
@@ -271,8 +333,49 @@ namespace transport_catalogue {
 
 			std::string GetSerializeFilePath();
 
+			std::string GetRouterTableFilePath();
+
+			graph::MapAdvice GetRouterTableAdvice();
+
+			StatSettings GetStatSettings();
+
+			std::optional<domain::RouteSettings> GetRouteSettings() const;
+
+			BusUpdates GetBusUpdates() const;
+
         private:
 
+			/**
+			 * @brief Reads Stop and Bus base requests into the pending catalogue updates.
+			 * @param requests The base requests.
+			 */
+			void ReadBaseRequests(const json::Array& requests);
+
+			/**
+			 * @brief Answers all the Route requests grouped by their starting stop.
+			 * Every distinct starting stop costs one call of TransportRouter::GetRoutesAndBuses.
+			 * The restricted requests are left to be answered one by one.
+			 * @param tc The transport catalogue.
+			 * @param router The transport router.
+			 * @return The routes indexed like output_requests_; std::nullopt for other requests and missing routes.
+			 */
+			std::vector<std::optional<graph::DestinationInfo>> ComputeBatchedRoutes(TransportCatalogue& tc, graph::TransportRouter& router) const;
+
+			/**
+			 * @brief Collects the stops and buses to avoid and the search bounds of a Route request.
+			 * @param request The Route request.
+			 * @return The restrictions, referring to the names held by the request.
+			 */
+			static graph::RouteRestrictions MakeRouteRestrictions(const OutputRequest& request);
+
+			/**
+			 * @brief Converts the activities of a route to the items of its response.
+			 * The item dictionaries are built in place and moved into the array; a name is copied only into its JSON string.
+			 * @param route The route.
+			 * @return The response items in travel order.
+			 */
+			static json::Array MakeRouteItems(const graph::DestinationInfo& route);
+
             std::istream& input_stream_;
             std::deque<OutputRequest> output_requests_;
             std::deque<domain::BusDescription> update_requests_bus_;
@@ -281,7 +384,12 @@ namespace transport_catalogue {
             RenderData render_data_;
             json::Document load_;   ///< The loaded JSON document.
             domain::RouteSettings route_settings_;
+			bool has_route_settings_ = false;	///< Whether the input of process_requests gives routing settings.
 			std::string serialize_file_path_;
+			StatSettings stat_settings_;	///< The settings for answering the stat requests.
+			std::string router_table_file_path_;	///< The separate routes table file, empty to keep the table in the base.
+			graph::MapAdvice router_table_advice_ = graph::MapAdvice::NORMAL;	///< The hint for mapping the routes table file.
+			BusUpdates bus_updates_;	///< The buses to add to or remove from the routes of the loaded base.
     };  
 
 }  // namespace transport_catalogue
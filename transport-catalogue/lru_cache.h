@@ -0,0 +1,105 @@
+#pragma once
+
+/**
+ * @file lru_cache.h
+ * @brief This file contains the LruCache class template, a bounded map evicting the least recently used entry.
+ */
+
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <list>
+#include <unordered_map>
+#include <utility>
+
+namespace cache {
+
+    /**
+     * @class LruCache
+     * @brief Class template keeping at most a given number of entries and evicting the least recently used one.
+     * Lookups and insertions take constant time on average. The lookups are counted as hits and misses.
+     * @tparam Key The key type.
+     * @tparam Value The value type.
+     * @tparam Hash The hash of the key type.
+     */
+    template <typename Key, typename Value, typename Hash = std::hash<Key>>
+    class LruCache {
+    public:
+        /**
+         * @brief Constructs an empty cache.
+         * @param capacity The maximum number of entries. A cache of zero capacity stores nothing.
+         */
+        explicit LruCache(size_t capacity)
+            : capacity_(capacity) {
+            index_.reserve(capacity);
+        }
+
+        /**
+         * @brief Finds the value of a key and marks the entry as the most recently used.
+         * @param key The key.
+         * @return The pointer to the value, valid until the next insertion, or nullptr if the key is not cached.
+         */
+        const Value* Find(const Key& key) {
+            auto it = index_.find(key);
+            if (it == index_.end()) {
+                ++miss_count_;
+                return nullptr;
+            }
+            ++hit_count_;
+            entries_.splice(entries_.begin(), entries_, it->second);
+            return &it->second->second;
+        }
+
+        /**
+         * @brief Stores the value of a key as the most recently used entry.
+         * When the cache is full, the node of the least recently used entry is reused for the new one.
+         * @param key The key.
+         * @param value The value.
+         */
+        void Insert(const Key& key, Value value) {
+            if (capacity_ == 0) {
+                return;
+            }
+            if (auto it = index_.find(key); it != index_.end()) {
+                it->second->second = std::move(value);
+                entries_.splice(entries_.begin(), entries_, it->second);
+                return;
+            }
+            if (entries_.size() == capacity_) {
+                index_.erase(entries_.back().first);
+                entries_.splice(entries_.begin(), entries_, std::prev(entries_.end()));
+                entries_.front() = { key, std::move(value) };
+            }
+            else {
+                entries_.emplace_front(key, std::move(value));
+            }
+            index_.emplace(key, entries_.begin());
+        }
+
+        size_t GetCapacity() const {
+            return capacity_;
+        }
+
+        size_t GetSize() const {
+            return entries_.size();
+        }
+
+        size_t GetHitCount() const {
+            return hit_count_;
+        }
+
+        size_t GetMissCount() const {
+            return miss_count_;
+        }
+
+    private:
+        using Entries = std::list<std::pair<Key, Value>>;
+
+        size_t capacity_;
+        Entries entries_;   /**< The entries from the most to the least recently used */
+        std::unordered_map<Key, typename Entries::iterator, Hash> index_;
+        size_t hit_count_ = 0;
+        size_t miss_count_ = 0;
+    };
+
+} // namespace cache
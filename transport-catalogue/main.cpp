@@ -31,8 +31,8 @@ int main(int argc, char* argv[]) {
         (void)reader.ReadInputJsonRequestForFillBase();
 
         reader.UpdStop(tc);
-        reader.UpdBus(tc);
         reader.UpdStopDist(tc);
+        reader.UpdBus(tc);
         reader.UpdRouteSettings(tc);
         reader.UpdSerializeSettings(tc);
 
@@ -41,8 +41,22 @@ int main(int argc, char* argv[]) {
         ofstream out_file(tc.GetSerializerFilePath(), ios::binary);
 
         domain::RouteSettings routeSettings = tc.GetRouteSettings();
+        graph::TransportRouter transport_router(tc);
+        if (transport_router.GetRemovedEdgeCount() > 0) {
+            std::cerr << "router graph: " << transport_router.GetRemovedEdgeCount() << " parallel edges removed, "
+                      << transport_router.GetGraph().GetEdgeCount() << " edges kept" << std::endl;
+        }
 
-        serialization::catalogue_serialization(tc, rd , routeSettings, out_file);
+        std::string router_table_file = reader.GetRouterTableFilePath();
+        if (transport_router.GetRouter() == nullptr) {
+            router_table_file.clear();
+        }
+        if (!router_table_file.empty()) {
+            graph::WriteRouterTableFile(router_table_file, *transport_router.GetRouter(), transport_router.GetGraph(),
+                                        transport_router.GetRouterTableFingerprint());
+        }
+
+        serialization::catalogue_serialization(tc, rd , routeSettings, transport_router, router_table_file, out_file);
 
     }
     else if (mode == "process_requests"sv) {
@@ -57,8 +71,39 @@ int main(int argc, char* argv[]) {
         tc.AddRouteSettings(catalogue.routing_settings_);
 
         MapRenderer mapdrawer(rd);
-        graph::TransportRouter transport_router(tc);
-        reader.ManageOutputRequests(tc, mapdrawer, transport_router);
+        if (catalogue.router_data_) {
+            if (!catalogue.router_data_->router_table_file.empty() && !reader.GetRouterTableFilePath().empty()) {
+                catalogue.router_data_->router_table_file = reader.GetRouterTableFilePath();
+            }
+            catalogue.router_data_->router_table_advice = reader.GetRouterTableAdvice();
+        }
+        std::unique_ptr<graph::TransportRouter> transport_router = catalogue.router_data_
+            ? std::make_unique<graph::TransportRouter>(tc, std::move(*catalogue.router_data_))
+            : std::make_unique<graph::TransportRouter>(tc);
+        if (std::optional<domain::RouteSettings> route_settings = reader.GetRouteSettings()) {
+            domain::RouteSettings base_route_settings = tc.GetRouteSettings();
+            if (route_settings->bus_wait_time != base_route_settings.bus_wait_time
+                || route_settings->bus_velocity != base_route_settings.bus_velocity) {
+                base_route_settings.bus_wait_time = route_settings->bus_wait_time;
+                base_route_settings.bus_velocity = route_settings->bus_velocity;
+                tc.AddRouteSettings(base_route_settings);
+                transport_router->UpdateRouteSettings();
+            }
+        }
+        const transport_catalogue::BusUpdates bus_updates = reader.GetBusUpdates();
+        reader.UpdBusUpdates(tc);
+        for (const std::string& bus : bus_updates.removed_buses) {
+            transport_router->RemoveBus(bus);
+        }
+        for (const std::string& bus : bus_updates.added_buses) {
+            transport_router->AddBus(bus);
+        }
+        transport_router->SetRouteCacheCapacity(reader.GetStatSettings().route_cache_size);
+        reader.ManageOutputRequests(tc, mapdrawer, *transport_router);
+        if (const graph::TransportRouter::RouteCache* route_cache = transport_router->GetRouteCache()) {
+            std::cerr << "route cache: " << route_cache->GetHitCount() << " hits, "
+                      << route_cache->GetMissCount() << " misses" << std::endl;
+        }
     }
     else {
         PrintUsage();
@@ -0,0 +1,425 @@
+/**
+ * @file raptor_router.cpp
+ * @brief This file contains the implementation of the RaptorRouter class.
+ */
+
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace graph {
+
+	namespace {
+
+		const double MINUTES_PER_KILOMETER = 1000.0 / 60.0;
+		constexpr double UNREACHABLE_TIME = std::numeric_limits<double>::infinity();
+		constexpr uint32_t NO_POSITION = std::numeric_limits<uint32_t>::max();
+	}
+
+	/**
+	 * @struct SearchState
+	 * @brief Scratch buffers of one search, kept per thread. Entries are valid only if their stamp is current.
+	 */
+	struct RaptorRouter::SearchState {
+		std::vector<double> arrivals;           /**< The best arrival at every stop over all rounds */
+		std::vector<Leg> legs;                  /**< The last ride of the best arrival */
+		std::vector<uint32_t> stamps;
+		std::vector<double> marked_arrivals;    /**< The arrival of the previous round at a marked stop */
+		std::vector<uint32_t> marked_stamps;    /**< Equals round_stamp if the stop was improved in the previous round */
+		std::vector<uint32_t> improved_stamps;  /**< Equals round_stamp + 1 if the stop was improved in the current round */
+		std::vector<uint32_t> marked;
+		std::vector<uint32_t> improved;
+		std::vector<uint32_t> route_starts;     /**< The earliest marked position of a queued route */
+		std::vector<uint32_t> route_stamps;
+		std::vector<uint32_t> queued_routes;
+		uint32_t stamp = 0;
+		uint32_t round_stamp = 0;
+
+		void Reset(size_t stop_count, size_t route_count) {
+			if (stamps.size() < stop_count) {
+				arrivals.resize(stop_count);
+				legs.resize(stop_count);
+				stamps.resize(stop_count, 0);
+				marked_arrivals.resize(stop_count);
+				marked_stamps.resize(stop_count, 0);
+				improved_stamps.resize(stop_count, 0);
+			}
+			if (route_stamps.size() < route_count) {
+				route_starts.resize(route_count);
+				route_stamps.resize(route_count, 0);
+			}
+			if (++stamp == 0) {
+				std::fill(stamps.begin(), stamps.end(), 0);
+				stamp = 1;
+			}
+		}
+
+		/**
+		 * @brief Starts a new round, wrapping the round stamps around if needed.
+		 */
+		void NextRound() {
+			round_stamp += 2;
+			if (round_stamp >= std::numeric_limits<uint32_t>::max() - 2) {
+				std::fill(marked_stamps.begin(), marked_stamps.end(), 0);
+				std::fill(improved_stamps.begin(), improved_stamps.end(), 0);
+				std::fill(route_stamps.begin(), route_stamps.end(), 0);
+				round_stamp = 2;
+			}
+		}
+
+		double GetArrival(uint32_t stop) const {
+			return stamps[stop] == stamp ? arrivals[stop] : UNREACHABLE_TIME;
+		}
+	};
+
+	/**
+	 * @brief Builds the routes from the buses of the catalogue.
+	 * The ride times along a route are kept as prefix sums, taken from the distance prefix sums of the bus,
+	 * so a ride between any two positions costs O(1). The distance prefix sums are kept as well for SetRouteSettings.
+	 * @param tc The transport catalogue.
+	 * @param routed_buses Whether every bus by catalogue id is routed; empty to route all the buses.
+	 */
+	RaptorRouter::RaptorRouter(transport_catalogue::TransportCatalogue& tc, const std::vector<bool>& routed_buses)
+		: wait_time_(tc.GetWaitTime()) {
+		const std::deque<domain::Stop>& stops = tc.GetStops();
+		std::unordered_map<std::string_view, uint32_t> catalogue_indexes;
+		for (uint32_t stop_index = 0; stop_index < stops.size(); ++stop_index) {
+			catalogue_indexes.emplace(stops[stop_index].stop_name, stop_index);
+		}
+
+		std::vector<std::vector<StopRoute>> stop_routes(stops.size());
+		for (const domain::Bus& bus : tc.GetBuses()) {
+			if (bus.stops.size() < 2 || (!routed_buses.empty() && !routed_buses.at(bus.id))) {
+				continue;
+			}
+			std::vector<uint32_t> bus_stops;
+			for (std::string_view stop_name : bus.stops) {
+				bus_stops.push_back(catalogue_indexes.at(stop_name));
+			}
+
+			for (int direction = 0; direction < (bus.type == "true" ? 1 : 2); ++direction) {
+				const domain::RoutePrefixSums& prefix_sums = direction == 0 ? bus.forward : bus.backward;
+				if (direction == 1) {
+					std::reverse(bus_stops.begin(), bus_stops.end());
+				}
+				const uint32_t route = static_cast<uint32_t>(routes_.size());
+				routes_.push_back({bus.bus_name, bus.id, static_cast<uint32_t>(route_stops_.size()), static_cast<uint32_t>(bus_stops.size())});
+				for (uint32_t position = 0; position < bus_stops.size(); ++position) {
+					route_stops_.push_back(bus_stops[position]);
+					route_distances_.push_back(prefix_sums.road_distances[position]);
+					stop_routes[bus_stops[position]].push_back({route, position});
+				}
+			}
+		}
+
+		stop_routes_offsets_.reserve(stops.size() + 1);
+		stop_routes_offsets_.push_back(0);
+		for (uint32_t stop_index = 0; stop_index < stops.size(); ++stop_index) {
+			stop_names_.push_back(stops[stop_index].stop_name);
+			if (!stop_routes[stop_index].empty()) {
+				stop_indexes_.emplace(stops[stop_index].stop_name, stop_index);
+			}
+			stop_routes_.insert(stop_routes_.end(), stop_routes[stop_index].begin(), stop_routes[stop_index].end());
+			stop_routes_offsets_.push_back(static_cast<uint32_t>(stop_routes_.size()));
+		}
+		SetRouteSettings(tc.GetWaitTime(), tc.GetVelocity());
+	}
+
+	/**
+	 * @brief Recomputes the ride times from the stored road distances and sets the wait time, in linear time.
+	 * @param wait_time The wait time at a stop in minutes.
+	 * @param velocity The bus velocity in km/h.
+	 */
+	void RaptorRouter::SetRouteSettings(double wait_time, double velocity) {
+		wait_time_ = wait_time;
+		const double meters_per_minute = velocity * MINUTES_PER_KILOMETER;
+		route_times_.resize(route_distances_.size());
+		for (size_t i = 0; i < route_distances_.size(); ++i) {
+			route_times_[i] = route_distances_[i] / meters_per_minute;
+		}
+	}
+
+	/**
+	 * @brief Retrieves the index of a stop served by at least one route.
+	 * @param stop_name The name of the stop.
+	 * @return The stop index, or std::nullopt if no route serves the stop.
+	 */
+	std::optional<uint32_t> RaptorRouter::GetStopIndex(std::string_view stop_name) const {
+		auto it = stop_indexes_.find(stop_name);
+		if (it == stop_indexes_.end()) {
+			return std::nullopt;
+		}
+		return it->second;
+	}
+
+	/**
+	 * @brief Builds the fastest route between two stops; rides that cannot beat the destination are pruned.
+	 * @param from The index of the starting stop.
+	 * @param to The index of the destination stop.
+	 * @param limits The bounds of the search.
+	 * @return The route, or std::nullopt if the destination cannot be reached within the time limit.
+	 * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+	 */
+	std::optional<RaptorRouter::RouteInfo> RaptorRouter::BuildRoute(uint32_t from, uint32_t to, const SearchLimits<double>& limits) const {
+		if (limits.max_weight && *limits.max_weight < 0.0) {
+			return std::nullopt;
+		}
+		thread_local SearchState state;
+		Search(state, from, to, limits);
+		return ExtractRoute(state, from, to);
+	}
+
+	/**
+	 * @brief Builds the fastest route between two stops avoiding some stops and buses.
+	 * The routes of the excluded buses are never scanned and no arrival is recorded at an excluded stop,
+	 * so such a stop is never boarded at either.
+	 * @param from The index of the starting stop.
+	 * @param to The index of the destination stop.
+	 * @param exclusions The stops and buses to avoid.
+	 * @param limits The bounds of the search.
+	 * @return The route, or std::nullopt if the destination cannot be reached within the time limit or either stop is excluded.
+	 * @throws std::invalid_argument if the stop exclusions do not cover every stop.
+	 * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+	 */
+	std::optional<RaptorRouter::RouteInfo> RaptorRouter::BuildRoute(uint32_t from, uint32_t to, const Exclusions& exclusions,
+	                                                                const SearchLimits<double>& limits) const {
+		if (exclusions.stops.size() != stop_names_.size()) {
+			throw std::invalid_argument("Stop exclusions don't match the stops");
+		}
+		if (from >= stop_names_.size() || to >= stop_names_.size()) {
+			throw std::out_of_range("Stop index is out of range");
+		}
+		if (exclusions.stops[from] || exclusions.stops[to] || (limits.max_weight && *limits.max_weight < 0.0)) {
+			return std::nullopt;
+		}
+		thread_local SearchState state;
+		Search(state, from, to, limits, &exclusions);
+		return ExtractRoute(state, from, to);
+	}
+
+	/**
+	 * @brief Builds the fastest routes from one stop to several stops with a single set of rounds.
+	 * @param from The index of the starting stop.
+	 * @param to The indexes of the destination stops.
+	 * @return The routes in the order of the destination stops.
+	 */
+	std::vector<std::optional<RaptorRouter::RouteInfo>> RaptorRouter::BuildRoutes(uint32_t from, const std::vector<uint32_t>& to) const {
+		thread_local SearchState state;
+		Search(state, from, std::nullopt, {});
+		std::vector<std::optional<RouteInfo>> routes;
+		routes.reserve(to.size());
+		for (const uint32_t stop : to) {
+			routes.push_back(ExtractRoute(state, from, stop));
+		}
+		return routes;
+	}
+
+	/**
+	 * @brief Computes the times of the fastest routes from one stop to several stops without building the routes.
+	 * @param from The index of the starting stop.
+	 * @param to The indexes of the destination stops.
+	 * @return The times in the order of the destination stops, std::nullopt where a stop cannot be reached.
+	 */
+	std::vector<std::optional<double>> RaptorRouter::BuildRouteWeights(uint32_t from, const std::vector<uint32_t>& to) const {
+		thread_local SearchState state;
+		Search(state, from, std::nullopt, {});
+		std::vector<std::optional<double>> weights;
+		weights.reserve(to.size());
+		for (const uint32_t stop : to) {
+			if (stop >= stop_names_.size()) {
+				throw std::out_of_range("Stop index is out of range");
+			}
+			const double arrival = state.GetArrival(stop);
+			weights.push_back(arrival == UNREACHABLE_TIME ? std::nullopt : std::optional<double>(arrival));
+		}
+		return weights;
+	}
+
+	/**
+	 * @brief Finds every stop reachable from a stop within a time budget.
+	 * @param from The index of the starting stop.
+	 * @param max_time The time budget.
+	 * @return Pairs of stop index and route time, the starting stop included.
+	 */
+	std::vector<std::pair<uint32_t, double>> RaptorRouter::BuildReachable(uint32_t from, double max_time) const {
+		std::vector<std::pair<uint32_t, double>> reachable;
+		if (max_time < 0.0) {
+			return reachable;
+		}
+		thread_local SearchState state;
+		Search(state, from, std::nullopt, { max_time, std::nullopt });
+		for (uint32_t stop = 0; stop < stop_names_.size(); ++stop) {
+			const double arrival = state.GetArrival(stop);
+			if (arrival != UNREACHABLE_TIME) {
+				reachable.emplace_back(stop, arrival);
+			}
+		}
+		return reachable;
+	}
+
+	/**
+	 * @brief Runs the rounds from a stop until no arrival improves.
+	 * The boarding at a stop uses its arrival of the previous round, kept aside, since the stop may improve again
+	 * in the current round. Only stops improved in the previous round are boarded: boarding at any other stop was
+	 * already tried in an earlier round with the same arrival.
+	 * @param state The search state.
+	 * @param from The index of the starting stop.
+	 * @param target The stop whose arrival bounds the search, or std::nullopt to compute all the arrivals.
+	 * @param limits The arrivals later than the time limit are not recorded; the deadline is checked for every scanned route.
+	 * @param exclusions The stops and buses to avoid, or nullptr to use them all.
+	 * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+	 */
+	void RaptorRouter::Search(SearchState& state, uint32_t from, std::optional<uint32_t> target, const SearchLimits<double>& limits,
+	                          const Exclusions* exclusions) const {
+		if (from >= stop_names_.size() || (target && *target >= stop_names_.size())) {
+			throw std::out_of_range("Stop index is out of range");
+		}
+		state.Reset(stop_names_.size(), routes_.size());
+		state.NextRound();
+		state.stamps[from] = state.stamp;
+		state.arrivals[from] = 0.0;
+		state.marked.assign(1, from);
+		state.marked_arrivals[from] = 0.0;
+		state.marked_stamps[from] = state.round_stamp;
+		const double max_time = limits.max_weight.value_or(UNREACHABLE_TIME);
+		DeadlineCheck deadline_check(limits.deadline);
+
+		while (!state.marked.empty()) {
+			state.queued_routes.clear();
+			for (const uint32_t stop : state.marked) {
+				for (uint32_t i = stop_routes_offsets_[stop]; i < stop_routes_offsets_[stop + 1]; ++i) {
+					const StopRoute& stop_route = stop_routes_[i];
+					if (exclusions != nullptr) {
+						const uint32_t bus = routes_[stop_route.route].bus;
+						if (bus < exclusions->buses.size() && exclusions->buses[bus]) {
+							continue;
+						}
+					}
+					if (state.route_stamps[stop_route.route] != state.round_stamp) {
+						state.route_stamps[stop_route.route] = state.round_stamp;
+						state.route_starts[stop_route.route] = stop_route.position;
+						state.queued_routes.push_back(stop_route.route);
+					}
+					else {
+						state.route_starts[stop_route.route] = std::min(state.route_starts[stop_route.route], stop_route.position);
+					}
+				}
+			}
+
+			state.improved.clear();
+			const uint32_t improved_stamp = state.round_stamp + 1;
+			for (const uint32_t route_index : state.queued_routes) {
+				deadline_check.Step();
+				const Route& route = routes_[route_index];
+				const uint32_t* stops = route_stops_.data() + route.first;
+				const double* times = route_times_.data() + route.first;
+
+				double boarding = UNREACHABLE_TIME;
+				uint32_t board_position = NO_POSITION;
+				for (uint32_t position = state.route_starts[route_index]; position < route.stop_count; ++position) {
+					const uint32_t stop = stops[position];
+					if (board_position != NO_POSITION && (exclusions == nullptr || !exclusions->stops[stop])) {
+						const double arrival = boarding + times[position];
+						const double bound = target ? std::min(state.GetArrival(*target), max_time) : max_time;
+						if (arrival < state.GetArrival(stop) && !(bound < arrival)) {
+							state.stamps[stop] = state.stamp;
+							state.arrivals[stop] = arrival;
+							state.legs[stop] = {route_index, board_position, position};
+							if (state.improved_stamps[stop] != improved_stamp) {
+								state.improved_stamps[stop] = improved_stamp;
+								state.improved.push_back(stop);
+							}
+						}
+					}
+					if (state.marked_stamps[stop] == state.round_stamp) {
+						const double candidate = state.marked_arrivals[stop] + wait_time_ - times[position];
+						if (candidate < boarding) {
+							boarding = candidate;
+							board_position = position;
+						}
+					}
+				}
+			}
+
+			state.NextRound();
+			state.marked.swap(state.improved);
+			for (const uint32_t stop : state.marked) {
+				state.marked_arrivals[stop] = state.arrivals[stop];
+				state.marked_stamps[stop] = state.round_stamp;
+			}
+		}
+	}
+
+	/**
+	 * @brief Reconstructs the route to a stop from the last rides of the best arrivals.
+	 * @param state The search state.
+	 * @param from The index of the starting stop.
+	 * @param to The index of the destination stop.
+	 * @return The route, or std::nullopt if the destination was not reached.
+	 */
+	std::optional<RaptorRouter::RouteInfo> RaptorRouter::ExtractRoute(const SearchState& state, uint32_t from, uint32_t to) const {
+		if (state.GetArrival(to) == UNREACHABLE_TIME) {
+			return std::nullopt;
+		}
+		RouteInfo route_info{state.arrivals[to], {}};
+		for (uint32_t stop = to; stop != from;) {
+			if (route_info.legs.size() > stop_names_.size()) {
+				throw std::logic_error("RAPTOR legs form a cycle");
+			}
+			const Leg& leg = state.legs[stop];
+			route_info.legs.push_back(leg);
+			stop = route_stops_[routes_[leg.route].first + leg.board_position];
+		}
+		std::reverse(route_info.legs.begin(), route_info.legs.end());
+		return route_info;
+	}
+
+	/**
+	 * @brief Retrieves the time charged for every boarding.
+	 * @return The bus wait time.
+	 */
+	double RaptorRouter::GetWaitTime() const {
+		return wait_time_;
+	}
+
+	/**
+	 * @brief Retrieves the bus of a route.
+	 * @param route The route index.
+	 * @return The bus name.
+	 */
+	std::string_view RaptorRouter::GetBusName(uint32_t route) const {
+		return routes_[route].bus_name;
+	}
+
+	/**
+	 * @brief Retrieves the stop at a position of a route.
+	 * @param route The route index.
+	 * @param position The position in the route.
+	 * @return The stop name.
+	 */
+	std::string_view RaptorRouter::GetStopName(uint32_t route, uint32_t position) const {
+		return stop_names_[route_stops_[routes_[route].first + position]];
+	}
+
+	/**
+	 * @brief Retrieves the name of a stop.
+	 * @param stop The stop index.
+	 * @return The stop name.
+	 */
+	std::string_view RaptorRouter::GetStopName(uint32_t stop) const {
+		return stop_names_.at(stop);
+	}
+
+	/**
+	 * @brief Retrieves the ride time of a leg.
+	 * @param leg The leg.
+	 * @return The time between the boarding and the alighting stop.
+	 */
+	double RaptorRouter::GetRideTime(const Leg& leg) const {
+		const double* times = route_times_.data() + routes_[leg.route].first;
+		return times[leg.alight_position] - times[leg.board_position];
+	}
+
+} // namespace graph
@@ -0,0 +1,184 @@
+#pragma once
+
+/**
+ * @file raptor_router.h
+ * @brief This file contains the declaration of the RaptorRouter class, a round-based router working on the bus stop sequences.
+ */
+
+#include "graph.h"
+#include "transport_catalogue.h"
+
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+    /**
+     * @class RaptorRouter
+     * @brief Class answering route requests with a round-based scan of the bus routes (RAPTOR).
+     * Round k finds the best arrivals with k boardings: every route serving a stop improved in round k - 1 is
+     * scanned once from the earliest such stop. Every boarding costs the bus wait time and a ride costs the
+     * ride time between the two stops, so the answers are those of the graph built by TransportRouter::AddKnots,
+     * while memory stays linear in the total number of stops of the routes.
+     */
+    class RaptorRouter {
+        public:
+            /**
+             * @struct Leg
+             * @brief Struct representing one ride: boarding and alighting positions on a route.
+             */
+            struct Leg {
+                uint32_t route;             /**< The route index */
+                uint32_t board_position;    /**< The position of the boarding stop in the route */
+                uint32_t alight_position;   /**< The position of the alighting stop in the route */
+            };
+
+            /**
+             * @struct RouteInfo
+             * @brief Struct representing a found route.
+             */
+            struct RouteInfo {
+                double weight;          /**< The total time, waiting included */
+                std::vector<Leg> legs;  /**< The rides in travel order */
+            };
+
+            /**
+             * @struct Exclusions
+             * @brief Struct representing the stops and buses a route must not use.
+             * An excluded stop is neither boarded nor alighted at, though the buses still pass it.
+             */
+            struct Exclusions {
+                std::vector<bool> stops;    /**< Whether every stop by index is excluded, one entry per stop of the catalogue */
+                std::vector<bool> buses;    /**< Whether every bus by catalogue id is excluded; missing buses are not */
+            };
+
+            /**
+             * @brief Builds the routes from the buses of the catalogue.
+             * A non-roundtrip bus gives one route per direction.
+             * @param tc The transport catalogue.
+             * @param routed_buses Whether every bus by catalogue id is routed; empty to route all the buses.
+             */
+            explicit RaptorRouter(transport_catalogue::TransportCatalogue& tc, const std::vector<bool>& routed_buses = {});
+
+            /**
+             * @brief Retrieves the index of a stop served by at least one route.
+             * @param stop_name The name of the stop.
+             * @return The stop index, or std::nullopt if no route serves the stop.
+             */
+            std::optional<uint32_t> GetStopIndex(std::string_view stop_name) const;
+
+            /**
+             * @brief Builds the fastest route between two stops.
+             * @param from The index of the starting stop.
+             * @param to The index of the destination stop.
+             * @param limits The bounds of the search.
+             * @return The route, or std::nullopt if the destination cannot be reached within the time limit.
+             * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+             */
+            std::optional<RouteInfo> BuildRoute(uint32_t from, uint32_t to, const SearchLimits<double>& limits = {}) const;
+
+            /**
+             * @brief Builds the fastest route between two stops avoiding some stops and buses.
+             * @param from The index of the starting stop.
+             * @param to The index of the destination stop.
+             * @param exclusions The stops and buses to avoid.
+             * @param limits The bounds of the search.
+             * @return The route, or std::nullopt if the destination cannot be reached within the time limit or either stop is excluded.
+             * @throws SearchTimeoutError if the search runs past the deadline of the limits.
+             */
+            std::optional<RouteInfo> BuildRoute(uint32_t from, uint32_t to, const Exclusions& exclusions,
+                                                const SearchLimits<double>& limits = {}) const;
+
+            /**
+             * @brief Builds the fastest routes from one stop to several stops with a single set of rounds.
+             * @param from The index of the starting stop.
+             * @param to The indexes of the destination stops.
+             * @return The routes in the order of the destination stops.
+             */
+            std::vector<std::optional<RouteInfo>> BuildRoutes(uint32_t from, const std::vector<uint32_t>& to) const;
+
+            /**
+             * @brief Computes the times of the fastest routes from one stop to several stops without building the routes.
+             * @param from The index of the starting stop.
+             * @param to The indexes of the destination stops.
+             * @return The times in the order of the destination stops, std::nullopt where a stop cannot be reached.
+             */
+            std::vector<std::optional<double>> BuildRouteWeights(uint32_t from, const std::vector<uint32_t>& to) const;
+
+            /**
+             * @brief Finds every stop reachable from a stop within a time budget.
+             * Arrivals beyond the budget are never recorded, so their stops are not scanned in the next round.
+             * @param from The index of the starting stop.
+             * @param max_time The time budget.
+             * @return Pairs of stop index and route time, the starting stop included.
+             */
+            std::vector<std::pair<uint32_t, double>> BuildReachable(uint32_t from, double max_time) const;
+
+            /**
+             * @brief Retrieves the name of a stop.
+             * @param stop The stop index.
+             * @return The stop name.
+             */
+            std::string_view GetStopName(uint32_t stop) const;
+
+            /**
+             * @brief Recomputes the ride times from the stored road distances and sets the wait time, in linear time.
+             * @param wait_time The wait time at a stop in minutes.
+             * @param velocity The bus velocity in km/h.
+             */
+            void SetRouteSettings(double wait_time, double velocity);
+
+            double GetWaitTime() const;
+            std::string_view GetBusName(uint32_t route) const;
+            std::string_view GetStopName(uint32_t route, uint32_t position) const;
+            double GetRideTime(const Leg& leg) const;
+
+        private:
+            /**
+             * @struct Route
+             * @brief Struct representing one direction of a bus: a slice of route_stops_ and route_times_.
+             */
+            struct Route {
+                std::string_view bus_name;
+                uint32_t bus;           /**< The catalogue id of the bus */
+                uint32_t first;         /**< The offset of the route in route_stops_ and route_times_ */
+                uint32_t stop_count;
+            };
+
+            /**
+             * @struct StopRoute
+             * @brief Struct representing one occurrence of a stop in a route.
+             */
+            struct StopRoute {
+                uint32_t route;
+                uint32_t position;
+            };
+
+            struct SearchState;
+
+            /**
+             * @brief Runs the rounds from a stop.
+             * @param target The stop whose arrival bounds the search, or std::nullopt to compute all the arrivals.
+             * @param limits The arrivals later than the time limit are not recorded; the deadline is checked for every scanned route.
+             * @param exclusions The stops and buses to avoid, or nullptr to use them all.
+             */
+            void Search(SearchState& state, uint32_t from, std::optional<uint32_t> target, const SearchLimits<double>& limits,
+                        const Exclusions* exclusions = nullptr) const;
+            std::optional<RouteInfo> ExtractRoute(const SearchState& state, uint32_t from, uint32_t to) const;
+
+            double wait_time_;
+            std::vector<Route> routes_;
+            std::vector<uint32_t> route_stops_;     /**< The stop indexes of all routes, route after route */
+            std::vector<double> route_times_;       /**< The ride time from the first stop of the route, parallel to route_stops_ */
+            std::vector<int64_t> route_distances_;  /**< The road distance from the first stop of the route, parallel to route_stops_ */
+            std::vector<uint32_t> stop_routes_offsets_; /**< stop_routes_ slice of every stop, stop_count + 1 offsets */
+            std::vector<StopRoute> stop_routes_;    /**< The route occurrences of the stops, stop after stop */
+            std::vector<std::string_view> stop_names_;
+            std::unordered_map<std::string_view, uint32_t> stop_indexes_;
+    };
+
+} // namespace graph
@@ -1,26 +1,179 @@
 #pragma once
 
 #include "graph.h"
+#include "thread_pool.h"
 
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <functional>
 #include <iterator>
+#include <limits>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <type_traits>
 #include <unordered_map>
 #include <utility>
 #include <vector>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <immintrin.h>
+#define TRANSPORT_CATALOGUE_HAS_AVX2_KERNEL
+#endif
+
 namespace graph {
 
+namespace detail {
+
+/**
+ * @brief Relaxes count cells of a routes table row through an intermediate vertex:
+ * weights_to[j] = min(weights_to[j], weight_from + weights_through[j]).
+ * An improved cell takes the last edge of the through route, or prev_edge_from if the through route is empty.
+ */
 template <typename Weight>
+void RelaxRow(Weight weight_from, uint32_t prev_edge_from, const Weight* weights_through,
+              const uint32_t* prev_edges_through, Weight* weights_to, uint32_t* prev_edges_to,
+              size_t count, Weight unreachable_weight, uint32_t no_edge) {
+    for (size_t j = 0; j < count; ++j) {
+        const Weight candidate_weight = AddWeights(weight_from, weights_through[j]);
+        if (weights_through[j] != unreachable_weight && candidate_weight < weights_to[j]) {
+            weights_to[j] = candidate_weight;
+            prev_edges_to[j] = prev_edges_through[j] != no_edge ? prev_edges_through[j] : prev_edge_from;
+        }
+    }
+}
+
+#ifdef TRANSPORT_CATALOGUE_HAS_AVX2_KERNEL
+/**
+ * @brief AVX2 version of RelaxRow for double weights: four cells are compared and blended at once.
+ * Unreachable cells hold infinity, so they never produce a smaller candidate and need no check.
+ */
+__attribute__((target("avx2")))
+inline void RelaxRowAvx2(double weight_from, uint32_t prev_edge_from, const double* weights_through,
+                         const uint32_t* prev_edges_through, double* weights_to, uint32_t* prev_edges_to,
+                         size_t count, uint32_t no_edge) {
+    const __m256d from = _mm256_set1_pd(weight_from);
+    size_t j = 0;
+    for (; j + 4 <= count; j += 4) {
+        const __m256d candidate = _mm256_add_pd(from, _mm256_loadu_pd(weights_through + j));
+        const __m256d current = _mm256_loadu_pd(weights_to + j);
+        const __m256d less = _mm256_cmp_pd(candidate, current, _CMP_LT_OQ);
+        const int mask = _mm256_movemask_pd(less);
+        if (mask == 0) {
+            continue;
+        }
+        _mm256_storeu_pd(weights_to + j, _mm256_blendv_pd(current, candidate, less));
+        for (int lane = 0; lane < 4; ++lane) {
+            if (mask & (1 << lane)) {
+                const uint32_t prev_edge_through = prev_edges_through[j + lane];
+                prev_edges_to[j + lane] = prev_edge_through != no_edge ? prev_edge_through : prev_edge_from;
+            }
+        }
+    }
+    for (; j < count; ++j) {
+        const double candidate_weight = weight_from + weights_through[j];
+        if (candidate_weight < weights_to[j]) {
+            weights_to[j] = candidate_weight;
+            prev_edges_to[j] = prev_edges_through[j] != no_edge ? prev_edges_through[j] : prev_edge_from;
+        }
+    }
+}
+
+/**
+ * @brief AVX2 version of RelaxRow for unsigned 32-bit weights: eight cells are compared and blended at once.
+ * Unreachable cells hold the maximum weight; they are masked out, as their candidates would wrap around.
+ * The sum of two reachable weights is assumed to fit in 32 bits.
+ */
+__attribute__((target("avx2")))
+inline void RelaxRowAvx2(uint32_t weight_from, uint32_t prev_edge_from, const uint32_t* weights_through,
+                         const uint32_t* prev_edges_through, uint32_t* weights_to, uint32_t* prev_edges_to,
+                         size_t count, uint32_t no_edge) {
+    const __m256i from = _mm256_set1_epi32(static_cast<int>(weight_from));
+    const __m256i unreachable = _mm256_set1_epi32(-1);
+    size_t j = 0;
+    for (; j + 8 <= count; j += 8) {
+        const __m256i through = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights_through + j));
+        const __m256i candidate = _mm256_add_epi32(from, through);
+        const __m256i current = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(weights_to + j));
+        // candidate < current holds where min(candidate, current) == candidate and the two differ.
+        const __m256i not_less = _mm256_or_si256(_mm256_cmpeq_epi32(_mm256_min_epu32(candidate, current), current),
+                                                 _mm256_cmpeq_epi32(through, unreachable));
+        const int mask = ~_mm256_movemask_ps(_mm256_castsi256_ps(not_less)) & 0xFF;
+        if (mask == 0) {
+            continue;
+        }
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(weights_to + j), _mm256_blendv_epi8(candidate, current, not_less));
+        for (int lane = 0; lane < 8; ++lane) {
+            if (mask & (1 << lane)) {
+                const uint32_t prev_edge_through = prev_edges_through[j + lane];
+                prev_edges_to[j + lane] = prev_edge_through != no_edge ? prev_edge_through : prev_edge_from;
+            }
+        }
+    }
+    RelaxRow(weight_from, prev_edge_from, weights_through + j, prev_edges_through + j,
+             weights_to + j, prev_edges_to + j, count - j, std::numeric_limits<uint32_t>::max(), no_edge);
+}
+
+inline bool HasAvx2() {
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    return has_avx2;
+}
+#endif
+
+}  // namespace detail
+
+/**
+ * @class Router
+ * @brief Router answering every query from a precomputed table of all the shortest routes.
+ * No route leaves a weakly connected component, so the table keeps one square component table per component
+ * and its memory is the sum of the squared component sizes instead of V x V. The vertices of a component table
+ * keep their relative order, so the table of a graph with a single component has the plain V x V layout.
+ * The table is computed with weights of its own, given per edge, so it may use another weight type than the graph
+ * without a second copy of the edges.
+ * @tparam Weight The weight type of the table: a floating-point type, or an unsigned integer type saturating at its maximum.
+ * @tparam GraphWeight The weight type of the graph.
+ */
+template <typename Weight, typename GraphWeight = Weight>
 class Router {
 private:
-    using Graph = DirectedWeightedGraph<Weight>;
+    using Graph = DirectedWeightedGraph<GraphWeight>;
 
 public:
-    explicit Router(const Graph& graph);
+    /** Weight of the cells whose target is unreachable from the source. */
+    static constexpr Weight UNREACHABLE_WEIGHT = std::numeric_limits<Weight>::has_infinity
+                                                     ? std::numeric_limits<Weight>::infinity()
+                                                     : std::numeric_limits<Weight>::max();
+    /** Previous edge of the cells without one: the diagonal and the unreachable cells. */
+    static constexpr uint32_t NO_EDGE = std::numeric_limits<uint32_t>::max();
+
+    /**
+     * @struct RoutesInternalData
+     * @brief The routes table as two contiguous planes: route weights and last edges of the routes.
+     * Each plane holds the row-major component tables one after another, in the order of the components.
+     */
+    struct RoutesInternalData {
+        std::vector<Weight> weights;
+        std::vector<uint32_t> prev_edges;
+    };
+
+    /**
+     * @brief Computes the routes table.
+     * @param edge_weights The weight of every edge of the graph by id. It is not copied and must outlive the router.
+     * @param components The component of every vertex, as labelled by ComputeWeakComponents. No edge may join two components.
+     */
+    Router(const Graph& graph, const std::vector<Weight>& edge_weights, const std::vector<uint32_t>& components);
+    Router(const Graph& graph, const std::vector<Weight>& edge_weights, const std::vector<uint32_t>& components,
+           RoutesInternalData routes_internal_data);
+
+    /**
+     * @brief Constructs a router querying the planes in place. They are not copied and must outlive the router.
+     */
+    Router(const Graph& graph, const std::vector<Weight>& edge_weights, const std::vector<uint32_t>& components,
+           const Weight* weights, const uint32_t* prev_edges);
+
+    Router(const Router&) = delete;
+    Router& operator=(const Router&) = delete;
 
     struct RouteInfo {
         Weight weight;
@@ -29,89 +182,613 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    /**
+     * @brief Retrieves the weight of the route between two vertices from the table, without building the route.
+     * @return The weight, or std::nullopt if the route does not exist.
+     */
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const;
+
+    /**
+     * @brief Updates the table after edges were added to the graph, instead of computing it again.
+     * Every inserted edge relaxes the rows of its component in O(n^2) for a component of n vertices,
+     * unless it does not improve the route between its own vertices; a component receiving more than n edges
+     * is computed again from scratch instead.
+     * The graph and the edge weights the router was built for must already hold the new edges; the graph may also
+     * have gained vertices, which start in components of their own until their edges are inserted.
+     * The router is left unchanged if this throws.
+     * @param components The new component of every vertex, as labelled by ComputeWeakComponents.
+     * @param edge_map The new id of every old edge. An old edge may map to another edge joining the same vertices
+     * if the new edge is not heavier.
+     * @param inserted_edges The edges of the graph that are new or replace a heavier old edge.
+     */
+    void InsertEdges(const std::vector<uint32_t>& components, const std::vector<uint32_t>& edge_map,
+                     const std::vector<EdgeId>& inserted_edges);
+
+    /**
+     * @brief Updates the table after edges were removed from the graph, instead of computing it again.
+     * Only the sources whose routes use a removed edge are searched again with Dijkstra's algorithm;
+     * the other rows keep their routes, as no route gets shorter.
+     * The graph and the edge weights the router was built for must no longer hold the removed edges.
+     * The router is left unchanged if this throws.
+     * @param components The new component of every vertex, as labelled by ComputeWeakComponents.
+     * @param edge_map The new id of every old edge, or NO_EDGE if the edge was removed.
+     * An edge of the graph that no old edge maps to must not be lighter than the removed edge joining the same vertices.
+     */
+    void RemoveEdges(const std::vector<uint32_t>& components, const std::vector<uint32_t>& edge_map);
+
+    const Weight* GetWeights() const {
+        return weights_;
+    }
+
+    const uint32_t* GetPrevEdges() const {
+        return prev_edges_;
+    }
+
+    /**
+     * @brief Retrieves the number of cells of each plane.
+     */
+    size_t GetCellCount() const {
+        return cell_count_;
+    }
+
+    /**
+     * @brief Computes the number of cells of each plane of the table for the given components.
+     * @param components The component of every vertex.
+     * @return The sum of the squared component sizes.
+     */
+    static size_t ComputeCellCount(const std::vector<uint32_t>& components) {
+        std::vector<size_t> component_sizes;
+        for (const uint32_t component : components) {
+            if (component >= component_sizes.size()) {
+                component_sizes.resize(component + 1, 0);
+            }
+            ++component_sizes[component];
+        }
+        size_t cell_count = 0;
+        for (const size_t component_size : component_sizes) {
+            cell_count += component_size * component_size;
+        }
+        return cell_count;
+    }
+
 private:
-    struct RouteInternalData {
-        Weight weight;
-        std::optional<EdgeId> prev_edge;
+    /**
+     * @struct ComponentTable
+     * @brief The row-major planes of one component, indexed by the positions of the vertices in the component.
+     */
+    struct ComponentTable {
+        Weight* weights;
+        uint32_t* prev_edges;
+        size_t vertex_count;
     };
-    using RoutesInternalData = std::vector<std::vector<std::optional<RouteInternalData>>>;
+
+    /**
+     * @brief Places the component tables in the planes and checks that no edge joins two components.
+     */
+    void InitializeLayout(const Graph& graph, const std::vector<uint32_t>& components) {
+        const size_t vertex_count = graph.GetVertexCount();
+        if (components.size() != vertex_count) {
+            throw std::invalid_argument("Components don't match the graph");
+        }
+        if (edge_weights_.size() != graph.GetEdgeCount()) {
+            throw std::invalid_argument("Edge weights don't match the graph");
+        }
+        components_ = components;
+        positions_.resize(vertex_count);
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            const uint32_t component = components_[vertex];
+            if (component >= vertex_count) {
+                throw std::invalid_argument("Components don't match the graph");
+            }
+            if (component >= component_sizes_.size()) {
+                component_sizes_.resize(component + 1, 0);
+            }
+            positions_[vertex] = component_sizes_[component]++;
+        }
+        table_offsets_.resize(component_sizes_.size());
+        for (size_t component = 0; component < component_sizes_.size(); ++component) {
+            table_offsets_[component] = cell_count_;
+            cell_count_ += static_cast<size_t>(component_sizes_[component]) * component_sizes_[component];
+        }
+        for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const Edge<GraphWeight>& edge = graph.GetEdge(edge_id);
+            if (components_[edge.from] != components_[edge.to]) {
+                throw std::invalid_argument("Components don't match the graph");
+            }
+        }
+    }
+
+    /**
+     * @brief Retrieves the first cell of the row of a vertex in the table of its component.
+     */
+    size_t GetRow(VertexId vertex) const {
+        const uint32_t component = components_[vertex];
+        return table_offsets_[component] + static_cast<size_t>(positions_[vertex]) * component_sizes_[component];
+    }
+
+    ComponentTable GetComponentTable(size_t component) {
+        return {routes_internal_data_.weights.data() + table_offsets_[component],
+                routes_internal_data_.prev_edges.data() + table_offsets_[component],
+                component_sizes_[component]};
+    }
 
     void InitializeRoutesInternalData(const Graph& graph) {
         const size_t vertex_count = graph.GetVertexCount();
+        if (graph.GetEdgeCount() >= NO_EDGE) {
+            throw std::length_error("Too many edges for the routes table");
+        }
+        const auto csr = graph.GetCsr();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
-            routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
-                    throw std::domain_error("Edges' weights should be non-negative");
-                }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+            InitializeRow(csr, vertex);
+        }
+    }
+
+    /**
+     * @brief Sets the row of a vertex to the routes of at most one edge: the vertex itself and its cheapest outgoing edges.
+     */
+    void InitializeRow(const typename Graph::CsrView& csr, VertexId vertex) {
+        const size_t row = GetRow(vertex);
+        Weight* weights = routes_internal_data_.weights.data() + row;
+        uint32_t* prev_edges = routes_internal_data_.prev_edges.data() + row;
+        std::fill(weights, weights + component_sizes_[components_[vertex]], UNREACHABLE_WEIGHT);
+        std::fill(prev_edges, prev_edges + component_sizes_[components_[vertex]], NO_EDGE);
+        weights[positions_[vertex]] = ZERO_WEIGHT;
+        for (EdgeId i = csr.offsets[vertex]; i < csr.offsets[vertex + 1]; ++i) {
+            const Weight edge_weight = edge_weights_[csr.edge_ids[i]];
+            if (IsNegativeWeight(edge_weight)) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const size_t cell = positions_[csr.targets[i]];
+            if (weights[cell] == UNREACHABLE_WEIGHT || weights[cell] > edge_weight) {
+                weights[cell] = edge_weight;
+                prev_edges[cell] = static_cast<uint32_t>(csr.edge_ids[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Relaxes the tile (block_from, block_to) of a component table through every vertex of block_through.
+     * Tiles are BLOCK_SIZE x BLOCK_SIZE squares of the table; the last ones may be smaller.
+     */
+    static void RelaxBlock(const ComponentTable& table, size_t block_through, size_t block_from, size_t block_to) {
+        const size_t vertex_count = table.vertex_count;
+        Weight* weights = table.weights;
+        uint32_t* prev_edges = table.prev_edges;
+        const size_t through_end = std::min(vertex_count, (block_through + 1) * BLOCK_SIZE);
+        const size_t from_end = std::min(vertex_count, (block_from + 1) * BLOCK_SIZE);
+        const size_t to_begin = block_to * BLOCK_SIZE;
+        const size_t to_count = std::min(vertex_count, to_begin + BLOCK_SIZE) - to_begin;
+
+        for (VertexId vertex_through = block_through * BLOCK_SIZE; vertex_through < through_end; ++vertex_through) {
+            const Weight* weights_through = weights + vertex_through * vertex_count + to_begin;
+            const uint32_t* prev_edges_through = prev_edges + vertex_through * vertex_count + to_begin;
+            for (VertexId vertex_from = block_from * BLOCK_SIZE; vertex_from < from_end; ++vertex_from) {
+                const Weight weight_from = weights[vertex_from * vertex_count + vertex_through];
+                if (weight_from == UNREACHABLE_WEIGHT) {
+                    continue;
                 }
+                const uint32_t prev_edge_from = prev_edges[vertex_from * vertex_count + vertex_through];
+                Weight* weights_to = weights + vertex_from * vertex_count + to_begin;
+                uint32_t* prev_edges_to = prev_edges + vertex_from * vertex_count + to_begin;
+                RelaxCells(weight_from, prev_edge_from, weights_through, prev_edges_through, weights_to, prev_edges_to, to_count);
             }
         }
     }
 
-    void RelaxRoute(VertexId vertex_from, VertexId vertex_to, const RouteInternalData& route_from,
-                    const RouteInternalData& route_to) {
-        auto& route_relaxing = routes_internal_data_[vertex_from][vertex_to];
-        const Weight candidate_weight = route_from.weight + route_to.weight;
-        if (!route_relaxing || candidate_weight < route_relaxing->weight) {
-            route_relaxing = {candidate_weight,
-                              route_to.prev_edge ? route_to.prev_edge : route_from.prev_edge};
+    /**
+     * @brief Relaxes count cells of a row with the kernel the CPU supports best.
+     */
+    static void RelaxCells(Weight weight_from, uint32_t prev_edge_from, const Weight* weights_through,
+                           const uint32_t* prev_edges_through, Weight* weights_to, uint32_t* prev_edges_to, size_t count) {
+#ifdef TRANSPORT_CATALOGUE_HAS_AVX2_KERNEL
+        if constexpr (std::is_same_v<Weight, double> || std::is_same_v<Weight, uint32_t>) {
+            if (detail::HasAvx2()) {
+                detail::RelaxRowAvx2(weight_from, prev_edge_from, weights_through, prev_edges_through,
+                                     weights_to, prev_edges_to, count, NO_EDGE);
+                return;
+            }
         }
+#endif
+        detail::RelaxRow(weight_from, prev_edge_from, weights_through, prev_edges_through,
+                         weights_to, prev_edges_to, count, UNREACHABLE_WEIGHT, NO_EDGE);
     }
 
-    void RelaxRoutesInternalDataThroughVertex(size_t vertex_count, VertexId vertex_through) {
-        for (VertexId vertex_from = 0; vertex_from < vertex_count; ++vertex_from) {
-            if (const auto& route_from = routes_internal_data_[vertex_from][vertex_through]) {
-                for (VertexId vertex_to = 0; vertex_to < vertex_count; ++vertex_to) {
-                    if (const auto& route_to = routes_internal_data_[vertex_through][vertex_to]) {
-                        RelaxRoute(vertex_from, vertex_to, *route_from, *route_to);
+    /**
+     * @brief Computes all shortest paths of a component with the blocked Floyd-Warshall algorithm.
+     * For every diagonal tile: the tile itself is relaxed first, then its row and column tiles in parallel,
+     * then all the remaining tiles in parallel. Tiles of one phase never write cells another tile of the phase reads.
+     */
+    static void ComputeComponentRoutes(threading::ThreadPool& pool, const ComponentTable& table) {
+        const size_t block_count = (table.vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE;
+
+        for (size_t block_through = 0; block_through < block_count; ++block_through) {
+            RelaxBlock(table, block_through, block_through, block_through);
+            if (block_count == 1) {
+                continue;
+            }
+
+            pool.ParallelFor(2 * block_count, [&](size_t task) {
+                const size_t block = task / 2;
+                if (block == block_through) {
+                    return;
+                }
+                if (task % 2 == 0) {
+                    RelaxBlock(table, block_through, block_through, block);
+                }
+                else {
+                    RelaxBlock(table, block_through, block, block_through);
+                }
+            });
+
+            pool.ParallelFor(block_count * block_count, [&](size_t task) {
+                const size_t block_from = task / block_count;
+                const size_t block_to = task % block_count;
+                if (block_from == block_through || block_to == block_through) {
+                    return;
+                }
+                RelaxBlock(table, block_through, block_from, block_to);
+            });
+        }
+    }
+
+    /**
+     * @brief Computes the table of every component with more than one vertex.
+     */
+    void ComputeRoutesInternalData() {
+        threading::ThreadPool pool = MakePool();
+        for (size_t component = 0; component < component_sizes_.size(); ++component) {
+            if (component_sizes_[component] > 1) {
+                ComputeComponentRoutes(pool, GetComponentTable(component));
+            }
+        }
+    }
+
+    /**
+     * @struct Layout
+     * @brief The component tables and planes of the router, set aside while they are being changed.
+     */
+    struct Layout {
+        std::vector<uint32_t> components;
+        std::vector<uint32_t> positions;
+        std::vector<uint32_t> component_sizes;
+        std::vector<size_t> table_offsets;
+        size_t cell_count = 0;
+        RoutesInternalData routes_internal_data;
+        const Weight* weights = nullptr;
+        const uint32_t* prev_edges = nullptr;
+    };
+
+    /**
+     * @brief Moves the component tables and planes out of the router, leaving it empty.
+     */
+    Layout TakeLayout() {
+        Layout layout{std::move(components_), std::move(positions_), std::move(component_sizes_), std::move(table_offsets_),
+                      cell_count_, std::move(routes_internal_data_), weights_, prev_edges_};
+        components_.clear();
+        positions_.clear();
+        component_sizes_.clear();
+        table_offsets_.clear();
+        cell_count_ = 0;
+        routes_internal_data_ = RoutesInternalData{};
+        weights_ = nullptr;
+        prev_edges_ = nullptr;
+        return layout;
+    }
+
+    /**
+     * @brief Puts back the component tables and planes taken by TakeLayout.
+     */
+    void RestoreLayout(Layout&& layout) noexcept {
+        components_ = std::move(layout.components);
+        positions_ = std::move(layout.positions);
+        component_sizes_ = std::move(layout.component_sizes);
+        table_offsets_ = std::move(layout.table_offsets);
+        cell_count_ = layout.cell_count;
+        routes_internal_data_ = std::move(layout.routes_internal_data);
+        weights_ = layout.weights;
+        prev_edges_ = layout.prev_edges;
+    }
+
+    /**
+     * @brief Moves the cells to the component tables of new components and makes the router own its planes.
+     * A cell is kept if its two vertices were in one component and still are; the other cells become unreachable.
+     * The graph may have gained vertices since the layout was built: their rows only reach themselves.
+     * @return The old layout, so that the caller can restore it if the update fails later on.
+     * The router is left unchanged if this throws.
+     */
+    Layout ChangeLayout(const std::vector<uint32_t>& components) {
+        Layout old_layout = TakeLayout();
+        try {
+            InitializeLayout(graph_, components);
+            routes_internal_data_.weights.assign(cell_count_, UNREACHABLE_WEIGHT);
+            routes_internal_data_.prev_edges.assign(cell_count_, NO_EDGE);
+        }
+        catch (...) {
+            RestoreLayout(std::move(old_layout));
+            throw;
+        }
+        const size_t old_vertex_count = old_layout.components.size();
+        std::vector<std::vector<VertexId>> component_vertices(component_sizes_.size());
+        for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+            component_vertices[components_[vertex]].push_back(vertex);
+        }
+        for (const std::vector<VertexId>& vertices : component_vertices) {
+            for (const VertexId from : vertices) {
+                const size_t row = GetRow(from);
+                if (from >= old_vertex_count) {
+                    routes_internal_data_.weights[row + positions_[from]] = ZERO_WEIGHT;
+                    continue;
+                }
+                const uint32_t old_component = old_layout.components[from];
+                const size_t old_row = old_layout.table_offsets[old_component]
+                    + static_cast<size_t>(old_layout.positions[from]) * old_layout.component_sizes[old_component];
+                for (const VertexId to : vertices) {
+                    if (to < old_vertex_count && old_layout.components[to] == old_component) {
+                        routes_internal_data_.weights[row + positions_[to]] = old_layout.weights[old_row + old_layout.positions[to]];
+                        routes_internal_data_.prev_edges[row + positions_[to]] = old_layout.prev_edges[old_row + old_layout.positions[to]];
                     }
                 }
             }
         }
+        weights_ = routes_internal_data_.weights.data();
+        prev_edges_ = routes_internal_data_.prev_edges.data();
+        return old_layout;
+    }
+
+    /**
+     * @brief Relaxes the rows of the component of an edge through the edge.
+     * The row of the edge's target never improves, so the rows may be relaxed concurrently.
+     * An edge not lighter than the route it joins already has improves no route, so it costs nothing.
+     */
+    void RelaxEdge(threading::ThreadPool& pool, EdgeId edge_id) {
+        const Edge<GraphWeight>& edge = graph_.GetEdge(edge_id);
+        const Weight edge_weight = edge_weights_[edge_id];
+        const uint32_t component = components_[edge.from];
+        const size_t component_size = component_sizes_[component];
+        Weight* weights = routes_internal_data_.weights.data() + table_offsets_[component];
+        uint32_t* prev_edges = routes_internal_data_.prev_edges.data() + table_offsets_[component];
+        const size_t position_from = positions_[edge.from];
+        const size_t position_to = positions_[edge.to];
+        if (weights[position_from * component_size + position_to] <= edge_weight) {
+            return;
+        }
+        const Weight* weights_through = weights + position_to * component_size;
+        const uint32_t* prev_edges_through = prev_edges + position_to * component_size;
+
+        pool.ParallelFor(component_size, [&](size_t position) {
+            Weight* weights_to = weights + position * component_size;
+            if (position == position_to || weights_to[position_from] == UNREACHABLE_WEIGHT) {
+                return;
+            }
+            RelaxCells(AddWeights(weights_to[position_from], edge_weight), static_cast<uint32_t>(edge_id),
+                       weights_through, prev_edges_through, weights_to, prev_edges + position * component_size, component_size);
+        });
+    }
+
+    /**
+     * @brief Computes the row of a source with Dijkstra's algorithm over the graph.
+     */
+    void ComputeRow(VertexId source) {
+        const auto csr = graph_.GetCsr();
+        const size_t row = GetRow(source);
+        Weight* weights = routes_internal_data_.weights.data() + row;
+        uint32_t* prev_edges = routes_internal_data_.prev_edges.data() + row;
+        std::fill(weights, weights + component_sizes_[components_[source]], UNREACHABLE_WEIGHT);
+        std::fill(prev_edges, prev_edges + component_sizes_[components_[source]], NO_EDGE);
+
+        using QueueItem = std::pair<Weight, VertexId>;
+        std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+        weights[positions_[source]] = ZERO_WEIGHT;
+        queue.emplace(ZERO_WEIGHT, source);
+        while (!queue.empty()) {
+            const auto [weight, vertex] = queue.top();
+            queue.pop();
+            if (weights[positions_[vertex]] < weight) {
+                continue;
+            }
+            for (EdgeId i = csr.offsets[vertex]; i < csr.offsets[vertex + 1]; ++i) {
+                const Weight candidate_weight = AddWeights(weight, edge_weights_[csr.edge_ids[i]]);
+                const size_t cell = positions_[csr.targets[i]];
+                if (candidate_weight < weights[cell]) {
+                    weights[cell] = candidate_weight;
+                    prev_edges[cell] = static_cast<uint32_t>(csr.edge_ids[i]);
+                    queue.emplace(candidate_weight, csr.targets[i]);
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Creates the pool for the table computations; it only gets several threads if some component spans several tiles.
+     */
+    threading::ThreadPool MakePool() const {
+        const bool has_tiled_component = std::any_of(component_sizes_.begin(), component_sizes_.end(),
+                                                      [](uint32_t component_size) { return component_size > BLOCK_SIZE; });
+        return threading::ThreadPool(has_tiled_component ? std::thread::hardware_concurrency() : 1);
     }
 
+    static constexpr size_t BLOCK_SIZE = 64;
+
     static constexpr Weight ZERO_WEIGHT{};
     const Graph& graph_;
+    const std::vector<Weight>& edge_weights_; /**< The weight of every edge of graph_ by id */
+    std::vector<uint32_t> components_;      /**< The component of every vertex */
+    std::vector<uint32_t> positions_;       /**< The position of every vertex in the table of its component */
+    std::vector<uint32_t> component_sizes_; /**< The number of vertices of every component */
+    std::vector<size_t> table_offsets_;     /**< The first cell of the table of every component */
+    size_t cell_count_ = 0;
     RoutesInternalData routes_internal_data_;
+    const Weight* weights_ = nullptr;
+    const uint32_t* prev_edges_ = nullptr;
 };
 
-template <typename Weight>
-Router<Weight>::Router(const Graph& graph)
+template <typename Weight, typename GraphWeight>
+Router<Weight, GraphWeight>::Router(const Graph& graph, const std::vector<Weight>& edge_weights, const std::vector<uint32_t>& components)
     : graph_(graph)
-    , routes_internal_data_(graph.GetVertexCount(),
-                            std::vector<std::optional<RouteInternalData>>(graph.GetVertexCount()))
+    , edge_weights_(edge_weights)
 {
+    InitializeLayout(graph, components);
+    routes_internal_data_.weights.assign(cell_count_, UNREACHABLE_WEIGHT);
+    routes_internal_data_.prev_edges.assign(cell_count_, NO_EDGE);
     InitializeRoutesInternalData(graph);
+    ComputeRoutesInternalData();
 
-    const size_t vertex_count = graph.GetVertexCount();
-    for (VertexId vertex_through = 0; vertex_through < vertex_count; ++vertex_through) {
-        RelaxRoutesInternalDataThroughVertex(vertex_count, vertex_through);
+    weights_ = routes_internal_data_.weights.data();
+    prev_edges_ = routes_internal_data_.prev_edges.data();
+}
+
+template <typename Weight, typename GraphWeight>
+Router<Weight, GraphWeight>::Router(const Graph& graph, const std::vector<Weight>& edge_weights, const std::vector<uint32_t>& components,
+                                    RoutesInternalData routes_internal_data)
+    : graph_(graph)
+    , edge_weights_(edge_weights)
+    , routes_internal_data_(std::move(routes_internal_data))
+{
+    InitializeLayout(graph, components);
+    if (routes_internal_data_.weights.size() != cell_count_ || routes_internal_data_.prev_edges.size() != cell_count_) {
+        throw std::invalid_argument("Routes data doesn't match the graph");
     }
+    weights_ = routes_internal_data_.weights.data();
+    prev_edges_ = routes_internal_data_.prev_edges.data();
 }
 
-template <typename Weight>
-std::optional<typename Router<Weight>::RouteInfo> Router<Weight>::BuildRoute(VertexId from,
-                                                                             VertexId to) const {
-    const auto& route_internal_data = routes_internal_data_.at(from).at(to);
-    if (!route_internal_data) {
+template <typename Weight, typename GraphWeight>
+Router<Weight, GraphWeight>::Router(const Graph& graph, const std::vector<Weight>& edge_weights, const std::vector<uint32_t>& components,
+                                    const Weight* weights, const uint32_t* prev_edges)
+    : graph_(graph)
+    , edge_weights_(edge_weights)
+    , weights_(weights)
+    , prev_edges_(prev_edges)
+{
+    InitializeLayout(graph, components);
+}
+
+template <typename Weight, typename GraphWeight>
+std::optional<typename Router<Weight, GraphWeight>::RouteInfo> Router<Weight, GraphWeight>::BuildRoute(VertexId from,
+                                                                                                       VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (components_[from] != components_[to]) {
         return std::nullopt;
     }
-    const Weight weight = route_internal_data->weight;
+    const Weight* weights_from = weights_ + GetRow(from);
+    const uint32_t* prev_edges_from = prev_edges_ + GetRow(from);
+    if (weights_from[positions_[to]] == UNREACHABLE_WEIGHT) {
+        return std::nullopt;
+    }
+    const Weight weight = weights_from[positions_[to]];
     std::vector<EdgeId> edges;
-    for (std::optional<EdgeId> edge_id = route_internal_data->prev_edge;
-         edge_id;
-         edge_id = routes_internal_data_[from][graph_.GetEdge(*edge_id).from]->prev_edge)
+    for (uint32_t edge_id = prev_edges_from[positions_[to]];
+         edge_id != NO_EDGE;
+         edge_id = prev_edges_from[positions_[graph_.GetEdge(edge_id).from]])
     {
-        edges.push_back(*edge_id);
+        edges.push_back(edge_id);
     }
     std::reverse(edges.begin(), edges.end());
 
     return RouteInfo{weight, std::move(edges)};
 }
 
-}  // namespace graph
\ No newline at end of file
+template <typename Weight, typename GraphWeight>
+void Router<Weight, GraphWeight>::InsertEdges(const std::vector<uint32_t>& components, const std::vector<uint32_t>& edge_map,
+                                              const std::vector<EdgeId>& inserted_edges) {
+    if (graph_.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for the routes table");
+    }
+    for (const EdgeId edge_id : inserted_edges) {
+        if (IsNegativeWeight(edge_weights_.at(edge_id))) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    Layout old_layout = ChangeLayout(components);
+    try {
+        for (uint32_t& prev_edge : routes_internal_data_.prev_edges) {
+            if (prev_edge != NO_EDGE) {
+                prev_edge = edge_map.at(prev_edge);
+            }
+        }
+
+        // Relaxing an edge costs n^2 for a component of n vertices and computing the component again n^3,
+        // so a component receiving more than n edges is computed again.
+        std::vector<size_t> inserted_counts(component_sizes_.size(), 0);
+        for (const EdgeId edge_id : inserted_edges) {
+            ++inserted_counts[components_[graph_.GetEdge(edge_id).from]];
+        }
+        std::vector<std::vector<VertexId>> recomputed_vertices(component_sizes_.size());
+        for (VertexId vertex = 0; vertex < components_.size(); ++vertex) {
+            if (inserted_counts[components_[vertex]] > component_sizes_[components_[vertex]]) {
+                recomputed_vertices[components_[vertex]].push_back(vertex);
+            }
+        }
+
+        threading::ThreadPool pool = MakePool();
+        const auto csr = graph_.GetCsr();
+        for (size_t component = 0; component < component_sizes_.size(); ++component) {
+            if (!recomputed_vertices[component].empty()) {
+                for (const VertexId vertex : recomputed_vertices[component]) {
+                    InitializeRow(csr, vertex);
+                }
+                ComputeComponentRoutes(pool, GetComponentTable(component));
+            }
+        }
+        for (const EdgeId edge_id : inserted_edges) {
+            if (recomputed_vertices[components_[graph_.GetEdge(edge_id).from]].empty()) {
+                RelaxEdge(pool, edge_id);
+            }
+        }
+    }
+    catch (...) {
+        RestoreLayout(std::move(old_layout));
+        throw;
+    }
+}
+
+template <typename Weight, typename GraphWeight>
+void Router<Weight, GraphWeight>::RemoveEdges(const std::vector<uint32_t>& components, const std::vector<uint32_t>& edge_map) {
+    Layout old_layout = ChangeLayout(components);
+    try {
+        std::vector<VertexId> affected_sources;
+        for (VertexId source = 0; source < components_.size(); ++source) {
+            uint32_t* prev_edges = routes_internal_data_.prev_edges.data() + GetRow(source);
+            bool is_affected = false;
+            for (size_t position = 0; position < component_sizes_[components_[source]]; ++position) {
+                if (prev_edges[position] != NO_EDGE) {
+                    prev_edges[position] = edge_map.at(prev_edges[position]);
+                    is_affected = is_affected || prev_edges[position] == NO_EDGE;
+                }
+            }
+            if (is_affected) {
+                affected_sources.push_back(source);
+            }
+        }
+
+        threading::ThreadPool pool = MakePool();
+        pool.ParallelFor(affected_sources.size(), [&](size_t i) {
+            ComputeRow(affected_sources[i]);
+        });
+    }
+    catch (...) {
+        RestoreLayout(std::move(old_layout));
+        throw;
+    }
+}
+
+template <typename Weight, typename GraphWeight>
+std::optional<Weight> Router<Weight, GraphWeight>::GetRouteWeight(VertexId from, VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (components_[from] != components_[to]) {
+        return std::nullopt;
+    }
+    const Weight weight = weights_[GetRow(from) + positions_[to]];
+    if (weight == UNREACHABLE_WEIGHT) {
+        return std::nullopt;
+    }
+    return weight;
+}
+
+}  // namespace graph
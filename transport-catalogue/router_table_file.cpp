@@ -0,0 +1,198 @@
+/**
+ * @file router_table_file.cpp
+ * @brief This file contains the implementation of writing and mapping the binary routes table file.
+ */
+
+#include "router_table_file.h"
+
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace graph {
+
+	namespace {
+
+		constexpr char ROUTER_TABLE_MAGIC[8] = { 'T', 'C', 'R', 'O', 'U', 'T', 'E', 'R' };
+		constexpr uint32_t ROUTER_TABLE_VERSION = 4;
+		constexpr uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+		constexpr uint64_t FNV_PRIME = 1099511628211ULL;
+
+		/**
+		 * @brief Mixes the bytes of a value into an FNV-1a hash.
+		 * @param hash The hash to update.
+		 * @param value The value.
+		 */
+		template <typename Value>
+		void HashValue(uint64_t& hash, const Value& value) {
+			unsigned char bytes[sizeof(Value)];
+			std::memcpy(bytes, &value, sizeof(Value));
+			for (const unsigned char byte : bytes) {
+				hash = (hash ^ byte) * FNV_PRIME;
+			}
+		}
+
+		/**
+		 * @brief Converts the advice to the madvise() flag.
+		 * @param advice The advice.
+		 * @return The madvise() flag.
+		 */
+		int ToMadviseFlag(MapAdvice advice) {
+			switch (advice) {
+				case MapAdvice::RANDOM:
+					return MADV_RANDOM;
+				case MapAdvice::SEQUENTIAL:
+					return MADV_SEQUENTIAL;
+				case MapAdvice::WILL_NEED:
+					return MADV_WILLNEED;
+				default:
+					return MADV_NORMAL;
+			}
+		}
+	}
+
+	/**
+	 * @brief Computes the fingerprint identifying the graph and the route settings of a routes table.
+	 * The edges are hashed by their road distance rather than their weight, so the fingerprint only
+	 * depends on the settings through the settings themselves.
+	 * @param graph The graph of the table.
+	 * @param wait_time The bus wait time of the route settings.
+	 * @param velocity The bus velocity of the route settings.
+	 * @return The 64-bit FNV-1a hash of the vertex count, the (from, to, distance) of every edge and the settings.
+	 */
+	uint64_t ComputeRouterTableFingerprint(const DirectedWeightedGraph<double>& graph, double wait_time, double velocity) {
+		uint64_t hash = FNV_OFFSET_BASIS;
+		HashValue(hash, static_cast<uint64_t>(graph.GetVertexCount()));
+		for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+			const Edge<double>& edge = graph.GetEdge(edge_id);
+			HashValue(hash, static_cast<uint64_t>(edge.from));
+			HashValue(hash, static_cast<uint64_t>(edge.to));
+			HashValue(hash, static_cast<int64_t>(edge.distance));
+		}
+		HashValue(hash, wait_time);
+		HashValue(hash, velocity);
+		return hash;
+	}
+
+	/**
+	 * @brief Writes the routes table of a router to a file.
+	 * The planes are written as they are laid out in memory, so no copy of the table is made.
+	 * @param path The path of the file.
+	 * @param router The router whose table is written.
+	 * @param graph The graph the router was built for.
+	 * @param fingerprint The fingerprint of the graph and the route settings, as stored in the base.
+	 * @throws std::runtime_error if the file cannot be written.
+	 */
+	void WriteRouterTableFile(const std::string& path, const TableRouter& router, const DirectedWeightedGraph<double>& graph,
+	                          uint64_t fingerprint) {
+		std::ofstream out(path, std::ios::binary | std::ios::trunc);
+		if (!out) {
+			throw std::runtime_error("cannot open router table file " + path);
+		}
+
+		RouterTableFileHeader header{};
+		std::memcpy(header.magic, ROUTER_TABLE_MAGIC, sizeof(header.magic));
+		header.version = ROUTER_TABLE_VERSION;
+		header.weight_size = sizeof(TableWeight);
+		header.vertex_count = graph.GetVertexCount();
+		header.edge_count = graph.GetEdgeCount();
+		header.fingerprint = fingerprint;
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		out.write(reinterpret_cast<const char*>(router.GetWeights()), router.GetCellCount() * sizeof(TableWeight));
+		out.write(reinterpret_cast<const char*>(router.GetPrevEdges()), router.GetCellCount() * sizeof(uint32_t));
+
+		if (!out) {
+			throw std::runtime_error("cannot write router table file " + path);
+		}
+	}
+
+	/**
+	 * @brief Maps the routes table file and checks that it was computed for the given graph.
+	 * Only the header is touched here; the cells are paged in on demand unless MapAdvice::WILL_NEED is given.
+	 * A failing madvise() is ignored, as the hints only affect performance.
+	 * The shape of the graph is not enough to tell two bases apart, so the file must also carry the fingerprint of the base.
+	 * @param path The path of the file.
+	 * @param graph The graph the table is used with.
+	 * @param components The component of every vertex of the graph.
+	 * @param fingerprint The fingerprint of the graph and the route settings stored in the base.
+	 * @param advice The hint given to the kernel for the mapping.
+	 * @throws std::runtime_error if the file cannot be mapped or does not match the graph.
+	 */
+	MappedRouterTable::MappedRouterTable(const std::string& path, const DirectedWeightedGraph<double>& graph,
+	                                     const std::vector<uint32_t>& components, uint64_t fingerprint, MapAdvice advice) {
+		const int fd = ::open(path.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw std::runtime_error("cannot open router table file " + path);
+		}
+
+		struct stat file_stat;
+		if (::fstat(fd, &file_stat) != 0) {
+			::close(fd);
+			throw std::runtime_error("cannot stat router table file " + path);
+		}
+		size_ = static_cast<size_t>(file_stat.st_size);
+
+		const size_t vertex_count = graph.GetVertexCount();
+		cell_count_ = TableRouter::ComputeCellCount(components);
+		if (size_ != sizeof(RouterTableFileHeader) + cell_count_ * (sizeof(TableWeight) + sizeof(uint32_t))) {
+			::close(fd);
+			throw std::runtime_error("router table file " + path + " doesn't match the graph");
+		}
+
+		data_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+		::close(fd);
+		if (data_ == MAP_FAILED) {
+			data_ = nullptr;
+			throw std::runtime_error("cannot map router table file " + path);
+		}
+
+		const auto* header = static_cast<const RouterTableFileHeader*>(data_);
+		if (std::memcmp(header->magic, ROUTER_TABLE_MAGIC, sizeof(header->magic)) != 0
+			|| header->version != ROUTER_TABLE_VERSION
+			|| header->weight_size != sizeof(TableWeight)
+			|| header->vertex_count != vertex_count
+			|| header->edge_count != graph.GetEdgeCount()) {
+			::munmap(data_, size_);
+			data_ = nullptr;
+			throw std::runtime_error("router table file " + path + " doesn't match the graph");
+		}
+		if (header->fingerprint != fingerprint) {
+			::munmap(data_, size_);
+			data_ = nullptr;
+			throw std::runtime_error("router table file " + path + " was computed for another base");
+		}
+
+		if (advice != MapAdvice::NORMAL) {
+			(void)::madvise(data_, size_, ToMadviseFlag(advice));
+		}
+	}
+
+	MappedRouterTable::~MappedRouterTable() {
+		if (data_) {
+			::munmap(data_, size_);
+		}
+	}
+
+	/**
+	 * @brief Retrieves the mapped weights plane.
+	 * @return The pointer to the row-major route weights.
+	 */
+	const TableWeight* MappedRouterTable::GetWeights() const {
+		return reinterpret_cast<const TableWeight*>(static_cast<const char*>(data_) + sizeof(RouterTableFileHeader));
+	}
+
+	/**
+	 * @brief Retrieves the mapped previous edges plane.
+	 * @return The pointer to the row-major last edges of the routes.
+	 */
+	const uint32_t* MappedRouterTable::GetPrevEdges() const {
+		return reinterpret_cast<const uint32_t*>(GetWeights() + cell_count_);
+	}
+
+} // namespace graph
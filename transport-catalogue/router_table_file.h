@@ -0,0 +1,117 @@
+#pragma once
+
+/**
+ * @file router_table_file.h
+ * @brief This file contains the declaration of the binary routes table file shared by process_requests runs through mmap.
+ */
+
+#include "router.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace graph {
+
+    /**
+     * @brief The weight of the all-pairs routes table: the travel time in tenths of a second.
+     * The integer weights take half the width of doubles and make the ties between routes exact.
+     */
+    using TableWeight = uint32_t;
+
+    /**
+     * @brief The all-pairs router over the graph with the weights in minutes, computing its table with TableWeight weights.
+     */
+    using TableRouter = Router<TableWeight, double>;
+
+    /**
+     * @enum MapAdvice
+     * @brief Enum listing the hints given to the kernel for a mapped routes table.
+     * There is no huge page hint: MADV_HUGEPAGE has no effect on a shared mapping of an ordinary file.
+     */
+    enum class MapAdvice {
+        NORMAL,         /**< No hint */
+        RANDOM,         /**< Pages are accessed in random order, read-ahead is disabled */
+        SEQUENTIAL,     /**< Pages are accessed sequentially, aggressive read-ahead */
+        WILL_NEED       /**< The whole table is read into the page cache right away */
+    };
+
+    /**
+     * @struct RouterTableFileHeader
+     * @brief Struct representing the header of the routes table file.
+     * The header is followed by the two planes of the table, exactly as Router keeps them in memory:
+     * the weights of the component tables one after another, then their 32-bit previous edges.
+     * Each plane has as many cells as the sum of the squared component sizes.
+     */
+    struct RouterTableFileHeader {
+        char magic[8];          /**< Always "TCROUTER" */
+        uint32_t version;       /**< The layout version of the file */
+        uint32_t weight_size;   /**< The size of one weight in bytes */
+        uint64_t vertex_count;  /**< The number of vertices of the graph the table was computed for */
+        uint64_t edge_count;    /**< The number of edges of the graph the table was computed for */
+        uint64_t fingerprint;   /**< The fingerprint of the graph and the route settings the table was computed for */
+    };
+
+    /**
+     * @brief Computes the fingerprint identifying the graph and the route settings of a routes table.
+     * Two bases with graphs of the same shape but different edges or settings get different fingerprints.
+     * @param graph The graph of the table.
+     * @param wait_time The bus wait time of the route settings.
+     * @param velocity The bus velocity of the route settings.
+     * @return The 64-bit FNV-1a hash of the vertex count, the (from, to, distance) of every edge and the settings.
+     */
+    uint64_t ComputeRouterTableFingerprint(const DirectedWeightedGraph<double>& graph, double wait_time, double velocity);
+
+    /**
+     * @brief Writes the routes table of a router to a file.
+     * @param path The path of the file.
+     * @param router The router whose table is written.
+     * @param graph The graph the router was built for.
+     * @param fingerprint The fingerprint of the graph and the route settings, as stored in the base.
+     * @throws std::runtime_error if the file cannot be written.
+     */
+    void WriteRouterTableFile(const std::string& path, const TableRouter& router, const DirectedWeightedGraph<double>& graph,
+                              uint64_t fingerprint);
+
+    /**
+     * @class MappedRouterTable
+     * @brief Class mapping a routes table file read-only into memory.
+     * The table is queried in place, so opening costs O(1) and all processes share the same page cache copy.
+     */
+    class MappedRouterTable {
+        public:
+            /**
+             * @brief Maps the routes table file and checks that it was computed for the given graph.
+             * @param path The path of the file.
+             * @param graph The graph the table is used with.
+             * @param components The component of every vertex of the graph.
+             * @param fingerprint The fingerprint of the graph and the route settings stored in the base.
+             * @param advice The hint given to the kernel for the mapping.
+             * @throws std::runtime_error if the file cannot be mapped or does not match the graph.
+             */
+            MappedRouterTable(const std::string& path, const DirectedWeightedGraph<double>& graph,
+                              const std::vector<uint32_t>& components, uint64_t fingerprint, MapAdvice advice);
+            ~MappedRouterTable();
+
+            MappedRouterTable(const MappedRouterTable&) = delete;
+            MappedRouterTable& operator=(const MappedRouterTable&) = delete;
+
+            /**
+             * @brief Retrieves the mapped weights plane.
+             * @return The pointer to the row-major route weights.
+             */
+            const TableWeight* GetWeights() const;
+
+            /**
+             * @brief Retrieves the mapped previous edges plane.
+             * @return The pointer to the row-major last edges of the routes.
+             */
+            const uint32_t* GetPrevEdges() const;
+
+        private:
+            void* data_ = nullptr;  /**< The start of the mapping */
+            size_t size_ = 0;       /**< The length of the mapping in bytes */
+            size_t cell_count_ = 0; /**< The number of cells in one plane */
+    };
+
+} // namespace graph
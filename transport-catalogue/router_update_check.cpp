@@ -0,0 +1,87 @@
+/**
+ * @file router_update_check.cpp
+ * @brief This file contains a tool checking that the incremental bus updates of a base give the routes of a fresh build.
+ *
+ * The tool reads the same JSON document as process_requests: the serialization settings of a base and its bus updates.
+ * It loads the base, applies the updates with TransportRouter::RemoveBus and TransportRouter::AddBus, builds a router
+ * from scratch over the same buses and compares the times between all the stops of both routers.
+ * It exits with 1 if any time differs; the stat requests are ignored.
+ */
+
+#include "json_reader.h"
+#include "serialization.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief Compares the times between all the stops of an updated router with those of a router built from scratch.
+ * The fresh router routes the same buses, so both must agree on every time; the routes themselves may differ on ties.
+ * @param tc The transport catalogue, with the stops and buses of the updates.
+ * @param updated_router The router the updates were applied to.
+ * @return The number of stop pairs whose times differ.
+ */
+size_t CountRouteMismatches(transport_catalogue::TransportCatalogue& tc, graph::TransportRouter& updated_router) {
+    graph::TransportRouter fresh_router(tc, updated_router.GetRoutedBuses());
+    std::vector<std::string_view> stops;
+    for (const domain::Stop& stop : tc.GetStops()) {
+        stops.push_back(stop.stop_name);
+    }
+    const auto updated_times = updated_router.GetRouteMatrix(stops, stops);
+    const auto fresh_times = fresh_router.GetRouteMatrix(stops, stops);
+    size_t mismatch_count = 0;
+    for (size_t from = 0; from < stops.size(); ++from) {
+        for (size_t to = 0; to < stops.size(); ++to) {
+            const std::optional<double>& updated_time = updated_times[from][to];
+            const std::optional<double>& fresh_time = fresh_times[from][to];
+            if (updated_time.has_value() != fresh_time.has_value()
+                || (updated_time && std::abs(*updated_time - *fresh_time) > 1e-9 * std::max(1.0, *fresh_time))) {
+                ++mismatch_count;
+            }
+        }
+    }
+    return mismatch_count;
+}
+
+int main() {
+    transport_catalogue::InputReaderJson reader(std::cin);
+    reader.ReadInputJsonSerializeSettings();
+    reader.ReadInputJsonBusUpdates();
+
+    std::ifstream in_file(reader.GetSerializeFilePath(), std::ios::binary);
+    auto catalogue = serialization::catalogue_deserialization(in_file);
+    transport_catalogue::TransportCatalogue tc = catalogue.transport_catalogue_;
+    tc.AddRouteSettings(catalogue.routing_settings_);
+
+    if (catalogue.router_data_) {
+        if (!catalogue.router_data_->router_table_file.empty() && !reader.GetRouterTableFilePath().empty()) {
+            catalogue.router_data_->router_table_file = reader.GetRouterTableFilePath();
+        }
+        catalogue.router_data_->router_table_advice = reader.GetRouterTableAdvice();
+    }
+    std::unique_ptr<graph::TransportRouter> transport_router = catalogue.router_data_
+        ? std::make_unique<graph::TransportRouter>(tc, std::move(*catalogue.router_data_))
+        : std::make_unique<graph::TransportRouter>(tc);
+
+    const transport_catalogue::BusUpdates bus_updates = reader.GetBusUpdates();
+    reader.UpdBusUpdates(tc);
+    for (const std::string& bus : bus_updates.removed_buses) {
+        transport_router->RemoveBus(bus);
+    }
+    for (const std::string& bus : bus_updates.added_buses) {
+        transport_router->AddBus(bus);
+    }
+
+    const size_t mismatch_count = CountRouteMismatches(tc, *transport_router);
+    std::cout << mismatch_count << " of " << tc.GetStops().size() * tc.GetStops().size()
+              << " stop pairs differ from a fresh build" << std::endl;
+    return mismatch_count == 0 ? 0 : 1;
+}
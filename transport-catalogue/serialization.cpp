@@ -298,6 +298,7 @@ namespace serialization {
 
         routing_settings_proto.set_bus_wait_time(routing_settings.bus_wait_time);
         routing_settings_proto.set_bus_velocity(routing_settings.bus_velocity);
+        routing_settings_proto.set_router_engine(static_cast<transport_catalogue_protobuf::RouterEngine>(routing_settings.router_engine));
 
         return routing_settings_proto;
     }
@@ -313,20 +314,175 @@ namespace serialization {
 
         routing_settings.bus_wait_time = routing_settings_proto.bus_wait_time();
         routing_settings.bus_velocity = routing_settings_proto.bus_velocity();
+        routing_settings.router_engine = static_cast<domain::RouterEngine>(routing_settings_proto.router_engine());
 
         return routing_settings;
     }
 
+    /**
+     * @brief Serializes the graph, the stop vertices and the routes table of the TransportRouter into a protobuf object.
+     * The component labels of the vertices are stored along with the graph.
+     * The routes table is stored as its two planes of component tables, weights in tenths of a second,
+     * including the Router sentinels for unreachable cells and missing edges.
+     * If the table was written to a separate file, only the file name and the fingerprint the file carries are stored.
+     * With the contraction hierarchies engine the vertex ranks and the shortcuts are stored instead,
+     * with the ALT engine the landmarks and their distance arrays.
+     * @param transport_router The TransportRouter object.
+     * @param router_table_file The file the routes table was written to, or an empty string to store the table in the base.
+     * @return The serialized TransportRouter protobuf object.
+     */
+    transport_catalogue_protobuf::TransportRouter transport_router_serialization(const graph::TransportRouter& transport_router,
+                                                                                 const std::string& router_table_file) {
+
+        transport_catalogue_protobuf::TransportRouter transport_router_proto;
+
+        const auto& graph = transport_router.GetGraph();
+        transport_catalogue_protobuf::Graph* graph_proto = transport_router_proto.mutable_graph();
+        graph_proto->set_vertex_count(graph.GetVertexCount());
+        for (graph::EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+            const auto& edge = graph.GetEdge(edge_id);
+            transport_catalogue_protobuf::Edge* edge_proto = graph_proto->add_edges();
+            edge_proto->set_from(edge.from);
+            edge_proto->set_to(edge.to);
+            edge_proto->set_weight(edge.weight);
+            edge_proto->set_span_count(edge.span_count);
+            edge_proto->set_name_id(edge.name_id);
+            edge_proto->set_distance(edge.distance);
+        }
+
+        for (const auto& [stop_id, vertex] : transport_router.GetStopVertices()) {
+            transport_catalogue_protobuf::StopVertex* stop_vertex_proto = transport_router_proto.add_stop_vertices();
+            stop_vertex_proto->set_stop_id(stop_id);
+            stop_vertex_proto->set_vertex(vertex);
+        }
+
+        const std::vector<uint32_t>& vertex_components = transport_router.GetVertexComponents();
+        transport_router_proto.mutable_vertex_components()->Add(vertex_components.begin(), vertex_components.end());
+
+        if (!router_table_file.empty()) {
+            transport_router_proto.set_router_table_file(router_table_file);
+            transport_router_proto.set_router_table_fingerprint(transport_router.GetRouterTableFingerprint());
+        }
+        else if (const graph::TableRouter* router = transport_router.GetRouter()) {
+            const size_t cell_count = router->GetCellCount();
+            transport_catalogue_protobuf::Router* router_proto = transport_router_proto.mutable_router();
+            router_proto->set_vertex_count(graph.GetVertexCount());
+            router_proto->mutable_weights()->Add(router->GetWeights(), router->GetWeights() + cell_count);
+            router_proto->mutable_prev_edges()->Add(router->GetPrevEdges(), router->GetPrevEdges() + cell_count);
+        }
+        else if (const graph::ContractionHierarchy<double>* hierarchy = transport_router.GetContractionHierarchy()) {
+            const auto& preprocessing = hierarchy->GetPreprocessing();
+            transport_catalogue_protobuf::ContractionHierarchy* hierarchy_proto = transport_router_proto.mutable_contraction_hierarchy();
+            hierarchy_proto->mutable_ranks()->Add(preprocessing.ranks.begin(), preprocessing.ranks.end());
+            for (const auto& shortcut : preprocessing.shortcuts) {
+                transport_catalogue_protobuf::Shortcut* shortcut_proto = hierarchy_proto->add_shortcuts();
+                shortcut_proto->set_from(shortcut.from);
+                shortcut_proto->set_to(shortcut.to);
+                shortcut_proto->set_weight(shortcut.weight);
+                shortcut_proto->set_first(shortcut.first);
+                shortcut_proto->set_second(shortcut.second);
+            }
+        }
+        else if (const graph::AltRouter<double>* alt_router = transport_router.GetAltRouter()) {
+            const auto& landmarks = alt_router->GetLandmarks();
+            transport_catalogue_protobuf::Landmarks* landmarks_proto = transport_router_proto.mutable_landmarks();
+            landmarks_proto->mutable_vertices()->Add(landmarks.vertices.begin(), landmarks.vertices.end());
+            landmarks_proto->mutable_from_landmarks()->Add(landmarks.from_landmarks.begin(), landmarks.from_landmarks.end());
+            landmarks_proto->mutable_to_landmarks()->Add(landmarks.to_landmarks.begin(), landmarks.to_landmarks.end());
+        }
+
+        return transport_router_proto;
+    }
+
+    /**
+     * @brief Deserializes the precomputed TransportRouter data from a protobuf object.
+     * @param transport_router_proto The serialized TransportRouter protobuf object.
+     * @return The deserialized TransportRouterData object.
+     * @throws std::runtime_error if the routes table, the contraction hierarchy or the landmarks do not match the graph.
+     */
+    graph::TransportRouterData transport_router_deserialization(const transport_catalogue_protobuf::TransportRouter& transport_router_proto) {
+
+        graph::TransportRouterData transport_router_data;
+
+        const auto& graph_proto = transport_router_proto.graph();
+        transport_router_data.graph = graph::DirectedWeightedGraph<double>(graph_proto.vertex_count());
+        for (const auto& edge_proto : graph_proto.edges()) {
+            transport_router_data.graph.AddEdge({edge_proto.from(), edge_proto.to(), edge_proto.weight(), edge_proto.name_id(), edge_proto.span_count(), edge_proto.distance()});
+        }
+
+        for (const auto& stop_vertex_proto : transport_router_proto.stop_vertices()) {
+            transport_router_data.stop_vertices.emplace_back(stop_vertex_proto.stop_id(), stop_vertex_proto.vertex());
+        }
+
+        transport_router_data.vertex_components.assign(transport_router_proto.vertex_components().begin(),
+                                                       transport_router_proto.vertex_components().end());
+
+        transport_router_data.router_table_file = transport_router_proto.router_table_file();
+        transport_router_data.router_table_fingerprint = transport_router_proto.router_table_fingerprint();
+
+        if (transport_router_proto.has_router()) {
+            const auto& router_proto = transport_router_proto.router();
+            const size_t vertex_count = router_proto.vertex_count();
+            const size_t cell_count = graph::TableRouter::ComputeCellCount(transport_router_data.vertex_components);
+            if (vertex_count != graph_proto.vertex_count()
+                || transport_router_data.vertex_components.size() != vertex_count
+                || static_cast<size_t>(router_proto.weights_size()) != cell_count
+                || static_cast<size_t>(router_proto.prev_edges_size()) != cell_count) {
+                throw std::runtime_error("serialized routes table doesn't match the graph");
+            }
+
+            transport_router_data.routes_internal_data = graph::TableRouter::RoutesInternalData{
+                std::vector<graph::TableWeight>(router_proto.weights().begin(), router_proto.weights().end()),
+                std::vector<uint32_t>(router_proto.prev_edges().begin(), router_proto.prev_edges().end())};
+        }
+
+        if (transport_router_proto.has_contraction_hierarchy()) {
+            const auto& hierarchy_proto = transport_router_proto.contraction_hierarchy();
+            if (static_cast<size_t>(hierarchy_proto.ranks_size()) != graph_proto.vertex_count()) {
+                throw std::runtime_error("serialized contraction hierarchy doesn't match the graph");
+            }
+
+            graph::ContractionHierarchy<double>::Preprocessing preprocessing;
+            preprocessing.ranks.assign(hierarchy_proto.ranks().begin(), hierarchy_proto.ranks().end());
+            preprocessing.shortcuts.reserve(hierarchy_proto.shortcuts_size());
+            for (const auto& shortcut_proto : hierarchy_proto.shortcuts()) {
+                preprocessing.shortcuts.push_back({shortcut_proto.from(), shortcut_proto.to(), shortcut_proto.weight(),
+                                                   shortcut_proto.first(), shortcut_proto.second()});
+            }
+            transport_router_data.contraction_hierarchy = std::move(preprocessing);
+        }
+
+        if (transport_router_proto.has_landmarks()) {
+            const auto& landmarks_proto = transport_router_proto.landmarks();
+            const size_t cell_count = landmarks_proto.vertices_size() * graph_proto.vertex_count();
+            if (static_cast<size_t>(landmarks_proto.from_landmarks_size()) != cell_count
+                || static_cast<size_t>(landmarks_proto.to_landmarks_size()) != cell_count) {
+                throw std::runtime_error("serialized landmarks don't match the graph");
+            }
+
+            transport_router_data.landmarks = graph::AltRouter<double>::Landmarks{
+                std::vector<graph::VertexId>(landmarks_proto.vertices().begin(), landmarks_proto.vertices().end()),
+                std::vector<double>(landmarks_proto.from_landmarks().begin(), landmarks_proto.from_landmarks().end()),
+                std::vector<double>(landmarks_proto.to_landmarks().begin(), landmarks_proto.to_landmarks().end())};
+        }
+
+        return transport_router_data;
+    }
+
     /**
      * @brief Serializes the Catalogue object into a protobuf object and writes it to the output stream.
      * @param transport_catalogue The Transport Catalogue object.
      * @param render_settings The RenderData object.
      * @param routing_settings The RouteSettings object.
+     * @param transport_router The TransportRouter object.
+     * @param router_table_file The file the routes table was written to, or an empty string to store the table in the base.
      * @param out The output stream to write the serialized data to.
      */
     void catalogue_serialization(const transport_catalogue::TransportCatalogue& transport_catalogue,
                                  const transport_catalogue::RenderData& render_settings,
                                  const domain::RouteSettings& routing_settings,
+                                 const graph::TransportRouter& transport_router,
+                                 const std::string& router_table_file,
                                  std::ostream& out) {
 
         transport_catalogue_protobuf::Catalogue catalogue_proto;
@@ -338,6 +494,7 @@ namespace serialization {
         *catalogue_proto.mutable_transport_catalogue() = std::move(transport_catalogue_proto);
         *catalogue_proto.mutable_render_settings() = std::move(render_settings_proto);
         *catalogue_proto.mutable_routing_settings() = std::move(routing_settings_proto);
+        *catalogue_proto.mutable_router() = transport_router_serialization(transport_router, router_table_file);
 
         catalogue_proto.SerializePartialToOstream(&out);
 
@@ -358,8 +515,14 @@ namespace serialization {
             throw std::runtime_error("cannot parse serialized file from istream");
         }
 
+        std::optional<graph::TransportRouterData> router_data;
+        if (catalogue_proto.has_router()) {
+            router_data = transport_router_deserialization(catalogue_proto.router());
+        }
+
         return {transport_catalogue_deserialization(catalogue_proto.transport_catalogue()),
                 render_settings_deserialization(catalogue_proto.render_settings()),
-                routing_settings_deserialization(catalogue_proto.routing_settings())};
+                routing_settings_deserialization(catalogue_proto.routing_settings()),
+                std::move(router_data)};
     }
 }  // namespace serialization
\ No newline at end of file
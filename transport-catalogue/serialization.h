@@ -15,6 +15,7 @@
 
 #include "transport_router.h"
 #include "transport_router.pb.h"
+#include "graph.pb.h"
 
 #include <iostream>
 
@@ -34,6 +35,7 @@ namespace serialization {
         transport_catalogue::TransportCatalogue transport_catalogue_;
         transport_catalogue::RenderData render_settings_;
         domain::RouteSettings routing_settings_;
+        std::optional<graph::TransportRouterData> router_data_;
     };
 
     /**
@@ -104,19 +106,39 @@ namespace serialization {
     domain::RouteSettings routing_settings_deserialization(const transport_catalogue_protobuf::RouteSettings& routing_settings_proto);
 
     /**
-     * @brief Serializes the Transport Catalogue, RenderData, and RouteSettings into a stream.
+     * @brief Serializes the graph, the stop vertices and the routes table of the TransportRouter into a protobuf object.
+     * @param transport_router The TransportRouter object to serialize.
+     * @param router_table_file The file the routes table was written to, or an empty string to store the table in the base.
+     * @return The serialized TransportRouter protobuf object.
+     */
+    transport_catalogue_protobuf::TransportRouter transport_router_serialization(const graph::TransportRouter& transport_router,
+                                                                                 const std::string& router_table_file);
+
+    /**
+     * @brief Deserializes the precomputed TransportRouter data from a protobuf object.
+     * @param transport_router_proto The serialized TransportRouter protobuf object.
+     * @return The deserialized TransportRouterData object.
+     */
+    graph::TransportRouterData transport_router_deserialization(const transport_catalogue_protobuf::TransportRouter& transport_router_proto);
+
+    /**
+     * @brief Serializes the Transport Catalogue, RenderData, RouteSettings and the TransportRouter into a stream.
      * @param transport_catalogue The Transport Catalogue object to serialize.
      * @param render_settings The RenderData object to serialize.
      * @param routing_settings The RouteSettings object to serialize.
+     * @param transport_router The TransportRouter object to serialize.
+     * @param router_table_file The file the routes table was written to, or an empty string to store the table in the base.
      * @param out The output stream to write the serialized data to.
      */
     void catalogue_serialization(const transport_catalogue::TransportCatalogue& transport_catalogue,
                                  const transport_catalogue::RenderData& render_settings,
                                  const domain::RouteSettings& routing_settings,
+                                 const graph::TransportRouter& transport_router,
+                                 const std::string& router_table_file,
                                  std::ostream& out);
 
     /**
-     * @brief Deserializes the Transport Catalogue, RenderData, and RouteSettings from a stream.
+     * @brief Deserializes the Transport Catalogue, RenderData, RouteSettings and the TransportRouter data from a stream.
      * @param in The input stream to read the serialized data from.
      * @return The deserialized Catalogue object.
      */
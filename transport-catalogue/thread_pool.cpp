@@ -0,0 +1,119 @@
+/**
+ * @file thread_pool.cpp
+ * @brief This file contains the implementation of the ThreadPool class.
+ */
+
+#include "thread_pool.h"
+
+#include <utility>
+
+namespace threading {
+
+	/**
+	 * @brief Constructs a ThreadPool object and starts thread_count - 1 workers.
+	 * @param thread_count The number of threads running a batch, the calling thread included.
+	 */
+	ThreadPool::ThreadPool(size_t thread_count) {
+		for (size_t i = 1; i < thread_count; ++i) {
+			workers_.emplace_back([this] { WorkerLoop(); });
+		}
+	}
+
+	/**
+	 * @brief Stops and joins the workers.
+	 */
+	ThreadPool::~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			stop_ = true;
+		}
+		batch_started_.notify_all();
+		for (std::thread& worker : workers_) {
+			worker.join();
+		}
+	}
+
+	/**
+	 * @brief Retrieves the number of threads running a batch, the calling thread included.
+	 * @return The number of threads.
+	 */
+	size_t ThreadPool::GetThreadCount() const {
+		return workers_.size() + 1;
+	}
+
+	/**
+	 * @brief Publishes a batch to the workers, takes part in it and waits for the workers to finish.
+	 * @param count The number of tasks.
+	 * @param task The callable taking the task index.
+	 */
+	void ThreadPool::RunBatch(size_t count, const std::function<void(size_t)>& task) {
+		if (workers_.empty() || count <= 1) {
+			for (size_t index = 0; index < count; ++index) {
+				task(index);
+			}
+			return;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			task_ = &task;
+			task_count_ = count;
+			next_index_ = 0;
+			busy_workers_ = workers_.size();
+			error_ = nullptr;
+			++generation_;
+		}
+		batch_started_.notify_all();
+
+		RunTasks();
+
+		std::unique_lock<std::mutex> lock(mutex_);
+		batch_finished_.wait(lock, [this] { return busy_workers_ == 0; });
+		task_ = nullptr;
+		if (error_) {
+			std::rethrow_exception(std::exchange(error_, nullptr));
+		}
+	}
+
+	/**
+	 * @brief Takes tasks of the current batch until none is left.
+	 */
+	void ThreadPool::RunTasks() {
+		for (size_t index = next_index_++; index < task_count_; index = next_index_++) {
+			try {
+				(*task_)(index);
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex_);
+				if (!error_) {
+					error_ = std::current_exception();
+				}
+			}
+		}
+	}
+
+	/**
+	 * @brief Waits for batches and runs their tasks until the pool is destroyed.
+	 */
+	void ThreadPool::WorkerLoop() {
+		size_t seen_generation = 0;
+		for (;;) {
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				batch_started_.wait(lock, [&] { return stop_ || generation_ != seen_generation; });
+				if (stop_) {
+					return;
+				}
+				seen_generation = generation_;
+			}
+
+			RunTasks();
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (--busy_workers_ == 0) {
+				batch_finished_.notify_one();
+			}
+		}
+	}
+
+} // namespace threading
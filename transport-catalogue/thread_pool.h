@@ -0,0 +1,72 @@
+#pragma once
+
+/**
+ * @file thread_pool.h
+ * @brief This file contains the declaration of the ThreadPool class running batches of independent tasks.
+ */
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace threading {
+
+    /**
+     * @class ThreadPool
+     * @brief Class keeping a set of worker threads that run batches of indexed tasks.
+     * The calling thread takes part in every batch, so a pool of one thread runs everything inline.
+     */
+    class ThreadPool {
+        public:
+            /**
+             * @brief Constructs a ThreadPool object.
+             * @param thread_count The number of threads running a batch, the calling thread included. Zero is treated as one.
+             */
+            explicit ThreadPool(size_t thread_count = std::thread::hardware_concurrency());
+            ~ThreadPool();
+
+            ThreadPool(const ThreadPool&) = delete;
+            ThreadPool& operator=(const ThreadPool&) = delete;
+
+            /**
+             * @brief Retrieves the number of threads running a batch, the calling thread included.
+             * @return The number of threads.
+             */
+            size_t GetThreadCount() const;
+
+            /**
+             * @brief Runs task(index) for every index in [0, count) and waits until all of them are done.
+             * The tasks must be independent. The first exception thrown by a task is rethrown here.
+             * Must not be called from inside a task.
+             * @param count The number of tasks.
+             * @param task The callable taking the task index.
+             */
+            template <typename Task>
+            void ParallelFor(size_t count, const Task& task) {
+                RunBatch(count, std::function<void(size_t)>(std::cref(task)));
+            }
+
+        private:
+            void RunBatch(size_t count, const std::function<void(size_t)>& task);
+            void RunTasks();
+            void WorkerLoop();
+
+            std::vector<std::thread> workers_;
+            std::mutex mutex_;
+            std::condition_variable batch_started_;
+            std::condition_variable batch_finished_;
+            const std::function<void(size_t)>* task_ = nullptr;  /**< The task of the current batch */
+            size_t task_count_ = 0;                               /**< The number of tasks in the current batch */
+            std::atomic<size_t> next_index_{ 0 };                 /**< The next task index to take */
+            size_t busy_workers_ = 0;                             /**< The workers that have not finished the current batch */
+            size_t generation_ = 0;                               /**< The number of batches started */
+            std::exception_ptr error_;                            /**< The first exception of the current batch */
+            bool stop_ = false;
+    };
+
+} // namespace threading
@@ -13,8 +13,6 @@ using namespace std;
 using namespace domain;
 namespace transport_catalogue {
 
-	const double MINUTES_PER_KILOMETER = 1000.0 / 60.0;
-
 	/**
 	 * @brief Добавляет автобус в транспортный каталог.
 	 * @param bus_desc Структура BusDescription с информацией об автобусе.
@@ -30,8 +28,13 @@ namespace transport_catalogue {
 			}
 		}
 		bptr.bus_name = bus_desc.bus_name;
+		bptr.id = static_cast<uint32_t>(buses_.size());
 		bptr.type = bus_desc.type;
 		bptr.stops = stops_ptr;
+		bptr.forward = ComputePrefixSums(stops_ptr.begin(), stops_ptr.end());
+		if (bptr.type != "true"s) {
+			bptr.backward = ComputePrefixSums(stops_ptr.rbegin(), stops_ptr.rend());
+		}
 		buses_.push_back(bptr);
 		Bus* bptr_bus = &buses_.back();
 		bus_name_to_bus_.emplace(bptr_bus->bus_name, bptr_bus);
@@ -40,11 +43,38 @@ namespace transport_catalogue {
 		}
 	}
 
+	/**
+	 * @brief Computes the prefix sums of the road and geographic distances along a sequence of stops.
+	 * The distances between the stops must already be added.
+	 * @param begin The iterator to the first stop name.
+	 * @param end The iterator past the last stop name.
+	 * @return The prefix sums, one element per stop.
+	 */
+	template <typename It>
+	RoutePrefixSums TransportCatalogue::ComputePrefixSums(It begin, It end) const {
+		RoutePrefixSums prefix_sums;
+		const Stop* prev_stop = nullptr;
+		for (It it = begin; it != end; ++it) {
+			const Stop* stop = FindStop(*it);
+			if (prev_stop == nullptr) {
+				prefix_sums.road_distances.push_back(0);
+				prefix_sums.geo_distances.push_back(0.0);
+			}
+			else {
+				prefix_sums.road_distances.push_back(prefix_sums.road_distances.back() + GetStopDistance(*prev_stop, *stop));
+				prefix_sums.geo_distances.push_back(prefix_sums.geo_distances.back() + geo::ComputeDistance(prev_stop->coordinates, stop->coordinates));
+			}
+			prev_stop = stop;
+		}
+		return prefix_sums;
+	}
+
 	/**
 	 * @brief Adds a stop to the transport catalogue.
 	 * @param stop The Stop structure with information about the stop.
 	 */
 	void TransportCatalogue::AddStop(Stop stop) {
+		stop.id = static_cast<uint32_t>(stops_.size());
 		stops_.push_back(move(stop));
 		Stop* ptr_stop = &stops_.back();
 		stop_name_to_stop_.emplace(string_view(ptr_stop->stop_name), ptr_stop);
@@ -90,51 +120,26 @@ namespace transport_catalogue {
 		AllBusInfoBusResponse bus_info;
 		const Bus* found_bus = FindBus(string(bus));
 		if (found_bus) {
-			deque<string_view> stops_v = found_bus->stops;
+			const deque<string_view>& stops_v = found_bus->stops;
 			double coord_length = 0;
-			int real_length = 0;
+			int64_t real_length = 0;
 			if (stops_v.size() != 0) {
 				bus_info.bus_name = bus;
+				unordered_set<string_view> unique_stops(stops_v.begin(), stops_v.end());
+				bus_info.quant_uniq_stops = unique_stops.size();
+				coord_length = found_bus->forward.geo_distances.back();
+				real_length = found_bus->forward.road_distances.back();
 
 				if (found_bus->type == "true"s) {
 					bus_info.quant_stops = stops_v.size();
-					unordered_set<string_view> unique_stops(stops_v.begin(), stops_v.end());
-					bus_info.quant_uniq_stops = unique_stops.size();
-					for (int i = 0; i < static_cast<int>(stops_v.size()) - 1; i++) {
-						const Stop* one = FindStop(stops_v[i]);
-						const Stop* two = FindStop(stops_v[i + 1]);
-						coord_length += geo::ComputeDistance(one->coordinates, two->coordinates);
-						real_length += GetStopDistance(*one, *two);
-					}
 				}
 				else {
 					bus_info.quant_stops = stops_v.size() * 2 - 1;
-					unordered_set<string_view> unique_stops(stops_v.begin(), stops_v.end());
-					bus_info.quant_uniq_stops = unique_stops.size();
-					for (int i = 0; i < static_cast<int>(stops_v.size()) - 1; i++) {
-						const Stop* one = FindStop(stops_v[i]);
-						const Stop* two = FindStop(stops_v[i + 1]);
-						coord_length += geo::ComputeDistance(one->coordinates, two->coordinates);
-						real_length += GetStopDistance(*one, *two);
-					}
-					for (auto it = stops_v.rbegin(); it != stops_v.rend(); ++it) {
-						if (it != stops_v.rbegin()) {
-
-							const Stop* two = FindStop(*it);
-							const Stop* one = FindStop(*(it - 1));
-
-							string st_one_name = one->stop_name;
-							string st_two_name = two->stop_name;
-
-							int new_length = GetStopDistance(*one, *two);
-
-							real_length += new_length;
-						}
-					}
+					real_length += found_bus->backward.road_distances.back();
 					coord_length += coord_length;
 				}
 
-				bus_info.route_length = real_length;
+				bus_info.route_length = static_cast<double>(real_length);
 				bus_info.route_curvature = real_length / coord_length;
 			}
 		}
@@ -173,7 +178,6 @@ namespace transport_catalogue {
 				Stop* another_stop_ptr = stop_name_to_stop_[el.first];
 				int distance = el.second;
 				stops_distance_.emplace(make_pair(main_stop_ptr, another_stop_ptr), distance);
-				stops_distance_time_.emplace(make_pair(main_stop_ptr, another_stop_ptr), distance/( bus_velocity_ * MINUTES_PER_KILOMETER));
 			}
 		}
 	}
@@ -224,6 +228,7 @@ namespace transport_catalogue {
 	void TransportCatalogue::AddRouteSettings(const domain::RouteSettings route_settings) {
 		bus_wait_time_ = route_settings.bus_wait_time;
 		bus_velocity_ = route_settings.bus_velocity;
+		router_engine_ = route_settings.router_engine;
 	}
 
 	/**
@@ -243,15 +248,6 @@ namespace transport_catalogue {
 		return stop_name_to_stop_.size();
 	}
 	
-	/**
-	 * @brief Gets the distances and times between stops.
-	 *
-	 * @return The unordered map with distances and times between stops.
-	 */
-	std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, double, detail::PairOfStopPointerUsingString> TransportCatalogue::GetstopsDistanceTime() {
-		return stops_distance_time_;
-	}
-
 	/**
 	 * @brief Gets the bus velocity in km/h.
 	 *
@@ -275,7 +271,6 @@ namespace transport_catalogue {
 			const Stop* endStop = distance.end;
 			int distanceValue = distance.distance;
 			stops_distance_.emplace(std::make_pair(startStop, endStop), distanceValue);
-			stops_distance_time_.emplace(std::make_pair(startStop, endStop), distanceValue / (bus_velocity_ * 1000 / 60));
 		}
 	}
 
@@ -289,6 +284,7 @@ namespace transport_catalogue {
         RouteSettings rs;
         rs.bus_velocity = bus_velocity_;
         rs.bus_wait_time = bus_wait_time_;
+        rs.router_engine = router_engine_;
         return rs;
     }
 
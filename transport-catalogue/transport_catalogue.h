@@ -7,6 +7,7 @@
 
 #include "domain.h"
 
+#include <optional>
 #include <string>
 #include "deque"
 #include <unordered_set>
@@ -22,6 +23,13 @@ namespace transport_catalogue {
 		std::string name;
 		std::string from;
 		std::string to;
+		std::vector<std::string> from_stops;	///< The origin stops of a RouteMatrix request.
+		std::vector<std::string> to_stops;		///< The destination stops of a RouteMatrix request.
+		double max_time = 0.0;					///< The time budget of a Reachable request.
+		std::vector<std::string> avoid_stops;	///< The stops a Route request must not board or alight at.
+		std::vector<std::string> avoid_buses;	///< The buses a Route request must not ride.
+		std::optional<double> max_total_time;	///< The longest acceptable total time of a Route request.
+		std::optional<double> compute_budget_ms;	///< The search time budget of a Route request in milliseconds.
 	};
 
 	struct StopComparer {
@@ -78,6 +86,7 @@ namespace transport_catalogue {
 			
 			/**
 			 * @brief Adds a bus to the transport catalogue.
+			 * The distances between its stops must already be added: they are summed into the bus prefix sums here.
 			 * @param bus The bus description.
 			 */
 			void AddBus(const domain::BusDescription& bus);
@@ -160,13 +169,6 @@ namespace transport_catalogue {
 			 */
 			double GetWaitTime();
 
-			/**
-			 * @brief Retrieves the distances between stops in the transport catalogue.
-			 *
-			 * @return The map of pairs of stop pointers to distances.
-			 */
-			std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, double, detail::PairOfStopPointerUsingString> GetstopsDistanceTime();
-			
 			/**
 			 * @brief Retrieves the velocity of buses.
 			 *
@@ -197,13 +199,16 @@ namespace transport_catalogue {
 		private:
 			double bus_wait_time_ = 6;			/**< In minutes */
 			double bus_velocity_ = 40;			/**< In km/h */
+			domain::RouterEngine router_engine_ = domain::RouterEngine::ALL_PAIRS; /**< The algorithm answering route requests */
 			std::deque<domain::Bus> buses_;		/**< The list of buses */
 			std::deque<domain::Stop> stops_;	/**< The list of stops */
         	std::unordered_map<std::string_view, domain::Stop*> stop_name_to_stop_; /**< The map of stop names to stop pointers */
         	std::unordered_map<std::string_view, domain::Bus*> bus_name_to_bus_; 	/**< The map of bus names to bus pointers */
         	std::unordered_map<std::string_view, std::set<std::string>> stop_info_; /**< The map of stop names to set of bus names */
 			std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, int, detail::PairOfStopPointerUsingString> stops_distance_; /**< The map of pairs of stop pointers to distance */
-			std::unordered_map<std::pair<const domain::Stop*, const domain::Stop*>, double, detail::PairOfStopPointerUsingString> stops_distance_time_;
 			std::string serialize_file_path_;
+
+			template <typename It>
+			domain::RoutePrefixSums ComputePrefixSums(It begin, It end) const;
 	};
 }  // namespace transport_catalogue
\ No newline at end of file
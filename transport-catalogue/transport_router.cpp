@@ -5,61 +5,684 @@
  */
 
 #include "transport_router.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <optional>
+#include <stdexcept>
+#include <thread>
+#include <tuple>
+#include <unordered_map>
 
 namespace graph {
 
 		const double MINUTES_PER_KILOMETER = 1000.0 / 60.0;
+		const double TABLE_WEIGHTS_PER_MINUTE = 600.0;
 
 		/**
 		 * @brief Constructs an TransportRouter object.
 		 * This constructor initializes the TransportRouter with a reference to the TransportCatalogue.
-		 * It creates a DirectedWeightedGraph and adds knots based on the stops in the TransportCatalogue.
-		 * It also creates a Router object for route calculation using the created graph.
+		 * It creates a DirectedWeightedGraph, adds knots based on the stops in the TransportCatalogue, freezes the graph
+		 * into its compressed sparse row layout and labels its weakly connected components.
+		 * It also creates the router selected in the route settings for route calculation using the created graph.
+		 * The RAPTOR router works on the bus stop sequences directly, so no graph is built for it.
 		 * @param tc The TransportCatalogue reference.
+		 * @param routed_buses Whether every bus by catalogue id is routed; empty to route all the buses.
 		 */
-		TransportRouter::TransportRouter(transport_catalogue::TransportCatalogue& tc)
-			: tc(tc) {
-			graph_ = DirectedWeightedGraph<double>(2 * tc.GetStopsQuantity());
+		TransportRouter::TransportRouter(transport_catalogue::TransportCatalogue& tc, std::vector<bool> routed_buses)
+			: tc(tc), routed_buses_(std::move(routed_buses)) {
+			if (routed_buses_.empty()) {
+				routed_buses_.assign(tc.GetBuses().size(), true);
+			}
+			routed_buses_.resize(tc.GetBuses().size(), false);
+			if (tc.GetRouteSettings().router_engine == domain::RouterEngine::RAPTOR) {
+				raptor_router_ = std::make_unique<graph::RaptorRouter>(tc, routed_buses_);
+				return;
+			}
+
+			graph_ = DirectedWeightedGraph<double>(tc.GetStopsQuantity());
 			AddKnots();
+			graph_.Freeze();
+			vertex_components_ = graph::ComputeWeakComponents(graph_);
+
+			if (tc.GetRouteSettings().router_engine == domain::RouterEngine::DIJKSTRA) {
+				dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_);
+			}
+			else if (tc.GetRouteSettings().router_engine == domain::RouterEngine::CONTRACTION_HIERARCHIES) {
+				contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_);
+			}
+			else if (tc.GetRouteSettings().router_engine == domain::RouterEngine::ALT) {
+				alt_router_ = std::make_unique<graph::AltRouter<double>>(graph_);
+			}
+			else {
+				table_weights_ = ComputeTableWeights(graph_);
+				router_ = std::make_unique<graph::TableRouter>(graph_, table_weights_, vertex_components_);
+			}
+		}
+
+		/**
+		 * @brief Constructs a TransportRouter object from the precomputed data.
+		 * The graph and the routes table are taken as is, so neither the graph nor the Router precomputation is rerun.
+		 * A table stored in a separate file is mapped and queried in place.
+		 * The table is only recomputed if the all-pairs router is requested and the data does not contain one;
+		 * the same holds for the contraction hierarchy, the ALT landmarks and the component labels.
+		 * @param tc The TransportCatalogue reference.
+		 * @param data The precomputed data loaded from the serialized base.
+		 */
+		TransportRouter::TransportRouter(transport_catalogue::TransportCatalogue& tc, TransportRouterData data)
+			: tc(tc), graph_(std::move(data.graph)), vertex_components_(std::move(data.vertex_components))
+			, routed_buses_(tc.GetBuses().size(), true) {
+			graph_.Freeze();
+			if (vertex_components_.size() != graph_.GetVertexCount()) {
+				vertex_components_ = graph::ComputeWeakComponents(graph_);
+			}
+			const std::deque<domain::Stop>& stops = tc.GetStops();
+			vertex_to_stop_.resize(graph_.GetVertexCount());
+			for (const auto& [stop_index, vertex] : data.stop_vertices) {
+				stop_to_vertex_.emplace(stops.at(stop_index).stop_name, vertex);
+				vertex_to_stop_.at(vertex) = static_cast<uint32_t>(stop_index);
+			}
 
-			router_ = std::unique_ptr<graph::Router<double>>(new graph::Router<double>(graph_));
+			if (tc.GetRouteSettings().router_engine == domain::RouterEngine::RAPTOR) {
+				raptor_router_ = std::make_unique<graph::RaptorRouter>(tc);
+			}
+			else if (tc.GetRouteSettings().router_engine == domain::RouterEngine::DIJKSTRA) {
+				dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_);
+			}
+			else if (tc.GetRouteSettings().router_engine == domain::RouterEngine::CONTRACTION_HIERARCHIES) {
+				contraction_hierarchy_ = data.contraction_hierarchy
+					? std::make_unique<graph::ContractionHierarchy<double>>(graph_, std::move(*data.contraction_hierarchy))
+					: std::make_unique<graph::ContractionHierarchy<double>>(graph_);
+			}
+			else if (tc.GetRouteSettings().router_engine == domain::RouterEngine::ALT) {
+				alt_router_ = data.landmarks
+					? std::make_unique<graph::AltRouter<double>>(graph_, std::move(*data.landmarks))
+					: std::make_unique<graph::AltRouter<double>>(graph_);
+			}
+			else if (!data.router_table_file.empty()) {
+				table_weights_ = ComputeTableWeights(graph_);
+				mapped_router_table_ = std::make_unique<MappedRouterTable>(data.router_table_file, graph_, vertex_components_,
+				                                                             data.router_table_fingerprint, data.router_table_advice);
+				router_ = std::make_unique<graph::TableRouter>(graph_, table_weights_, vertex_components_,
+				                                               mapped_router_table_->GetWeights(), mapped_router_table_->GetPrevEdges());
+			}
+			else if (data.routes_internal_data) {
+				table_weights_ = ComputeTableWeights(graph_);
+				router_ = std::make_unique<graph::TableRouter>(graph_, table_weights_, vertex_components_, std::move(*data.routes_internal_data));
+			}
+			else {
+				table_weights_ = ComputeTableWeights(graph_);
+				router_ = std::make_unique<graph::TableRouter>(graph_, table_weights_, vertex_components_);
+			}
 		}
 
 		/**
 		 * @brief Adds knots to the graph based on the stops in the TransportCatalogue.
 		 * This function iterates through the buses in the TransportCatalogue and adds stops as knots to the graph.
 		 * It distinguishes between round-trip and non-round-trip buses and adds the stops accordingly.
+		 * The vertices are assigned up front, so the buses are split into one contiguous range per thread
+		 * and the edges of every range are collected into a buffer of its own. The buffers are concatenated
+		 * in range order, then parallel edges are pruned before they reach the graph: only the cheapest edge
+		 * of every vertex pair is kept.
 		 */
 		void TransportRouter::AddKnots() {
-			const std::deque<domain::Bus>& buses_ = tc.GetBuses();
+			removed_edge_count_ = AddBusEdges(graph_, AssignVertices(), routed_buses_);
+		}
+
+		/**
+		 * @brief Collects the edges of the given buses in parallel and adds the dominating ones to a graph.
+		 * The buses are split into one contiguous range per thread, so the graph does not depend on the thread count.
+		 * @param graph The graph the edges are added to.
+		 * @param stop_vertices The vertex of every stop by catalogue id.
+		 * @param routed_buses Whether every bus by catalogue id is routed.
+		 * @return The number of parallel edges dropped.
+		 */
+		size_t TransportRouter::AddBusEdges(DirectedWeightedGraph<double>& graph, const std::vector<std::optional<VertexId>>& stop_vertices,
+		                                    const std::vector<bool>& routed_buses) const {
+			const size_t bus_count = tc.GetBuses().size();
+			threading::ThreadPool pool(bus_count > 1 ? std::thread::hardware_concurrency() : 1);
+			const size_t range_count = std::min(pool.GetThreadCount(), std::max<size_t>(bus_count, 1));
+			std::vector<std::vector<Edge<double>>> range_edges(range_count);
+			pool.ParallelFor(range_count, [&](size_t range) {
+				range_edges[range] = CollectEdges(stop_vertices, routed_buses, bus_count * range / range_count, bus_count * (range + 1) / range_count);
+			});
+
+			size_t edge_count = 0;
+			for (const std::vector<Edge<double>>& edges : range_edges) {
+				edge_count += edges.size();
+			}
+			std::vector<Edge<double>> edges;
+			edges.reserve(edge_count);
+			for (std::vector<Edge<double>>& range : range_edges) {
+				edges.insert(edges.end(), range.begin(), range.end());
+				std::vector<Edge<double>>().swap(range);
+			}
+
+			return AddDominatingEdges(graph, std::move(edges));
+		}
 
-			for (const domain::Bus& bus : buses_) {
-				std::string type = bus.type;
-				std::deque<std::string_view> stops = bus.stops;
+		/**
+		 * @brief Assigns a vertex to every stop served by a bus, in the order of the stops in the catalogue.
+		 * @return The vertex of every stop by catalogue id; the stops no bus serves get no vertex.
+		 */
+		std::vector<std::optional<VertexId>> TransportRouter::AssignVertices() {
+			const std::deque<domain::Stop>& stops = tc.GetStops();
+			const std::vector<bool> served = FindServedStops(routed_buses_);
 
-				if (type == "true") {
-					AddStopsOneDirection(stops, bus.bus_name);
+			std::vector<std::optional<VertexId>> stop_vertices(stops.size());
+			for (const domain::Stop& stop : stops) {
+				if (served[stop.id]) {
+					stop_vertices[stop.id] = vertex_to_stop_.size();
+					stop_to_vertex_.emplace(stop.stop_name, vertex_to_stop_.size());
+					vertex_to_stop_.push_back(stop.id);
+				}
+			}
+			return stop_vertices;
+		}
+
+		/**
+		 * @brief Finds the stops served by the given buses.
+		 * A bus with less than two stops serves no stop, as it has no ride.
+		 * @param routed_buses Whether every bus by catalogue id is routed.
+		 * @return Whether every stop by catalogue id is served.
+		 */
+		std::vector<bool> TransportRouter::FindServedStops(const std::vector<bool>& routed_buses) const {
+			std::vector<bool> served(tc.GetStops().size(), false);
+			for (const domain::Bus& bus : tc.GetBuses()) {
+				if (bus.stops.size() < 2 || !routed_buses[bus.id]) {
+					continue;
+				}
+				for (std::string_view stop : bus.stops) {
+					served[tc.FindStop(stop)->id] = true;
+				}
+			}
+			return served;
+		}
+
+		/**
+		 * @brief Keeps the vertices of the stops still served by the given buses and gives free or new vertices to the newly served ones.
+		 * The stops no routed bus serves any more lose their vertex, which stays in the graph without edges
+		 * and is handed to the next newly served stop. When no vertex is free, the graph grows by one vertex.
+		 * The vertices of the other stops never move, so the rows of the all-pairs table stay where they are.
+		 * @param routed_buses Whether every bus by catalogue id is routed.
+		 * @return The new vertices; the current ones are left unchanged.
+		 */
+		TransportRouter::VertexAssignment TransportRouter::UpdateVertices(const std::vector<bool>& routed_buses) const {
+			const std::deque<domain::Stop>& stops = tc.GetStops();
+			const std::vector<bool> served = FindServedStops(routed_buses);
+			const size_t vertex_count = graph_.GetVertexCount();
+
+			VertexAssignment assignment{ std::vector<std::optional<VertexId>>(stops.size()), stop_to_vertex_, vertex_to_stop_ };
+			assignment.vertex_to_stop.resize(vertex_count);
+			std::vector<bool> used(vertex_count, false);
+			for (auto it = assignment.stop_to_vertex.begin(); it != assignment.stop_to_vertex.end();) {
+				const size_t stop_id = tc.FindStop(it->first)->id;
+				if (served[stop_id]) {
+					assignment.stop_vertices[stop_id] = it->second;
+					used[it->second] = true;
+					++it;
 				}
 				else {
-					AddStopsNonRoundTrip(stops, bus.bus_name);
+					it = assignment.stop_to_vertex.erase(it);
 				}
+			}
 
+			VertexId free_vertex = 0;
+			for (const domain::Stop& stop : stops) {
+				if (!served[stop.id] || assignment.stop_vertices[stop.id]) {
+					continue;
+				}
+				while (free_vertex < vertex_count && used[free_vertex]) {
+					++free_vertex;
+				}
+				VertexId vertex = free_vertex;
+				if (free_vertex < vertex_count) {
+					used[free_vertex] = true;
+					assignment.vertex_to_stop[vertex] = static_cast<uint32_t>(stop.id);
+				}
+				else {
+					vertex = assignment.vertex_to_stop.size();
+					assignment.vertex_to_stop.push_back(static_cast<uint32_t>(stop.id));
+				}
+				assignment.stop_vertices[stop.id] = vertex;
+				assignment.stop_to_vertex.emplace(stop.stop_name, vertex);
 			}
+			return assignment;
+		}
+
+		/**
+		 * @brief Collects the edges of a range of buses.
+		 * Only the catalogue and the given vertices are read, so ranges may be collected concurrently.
+		 * @param stop_vertices The vertex of every stop by catalogue id, as assigned by AssignVertices.
+		 * @param routed_buses Whether every bus by catalogue id is routed.
+		 * @param first The index of the first bus in the catalogue.
+		 * @param last The index past the last bus in the catalogue.
+		 * @return The edges of the buses, parallel edges included.
+		 */
+		std::vector<Edge<double>> TransportRouter::CollectEdges(const std::vector<std::optional<VertexId>>& stop_vertices,
+		                                                        const std::vector<bool>& routed_buses, size_t first, size_t last) const {
+			const std::deque<domain::Bus>& buses = tc.GetBuses();
+			std::vector<Edge<double>> edges;
+
+			for (size_t bus_index = first; bus_index < last; ++bus_index) {
+				const domain::Bus& bus = buses[bus_index];
+				if (bus.stops.size() < 2 || !routed_buses[bus_index]) {
+					continue;
+				}
+				std::vector<size_t> vertices;
+				vertices.reserve(bus.stops.size());
+				for (std::string_view stop : bus.stops) {
+					vertices.push_back(*stop_vertices[tc.FindStop(stop)->id]);
+				}
+
+				if (bus.type == "true") {
+					AddStopsOneDirection(vertices, bus.forward, bus.id, edges);
+				}
+				else {
+					AddStopsNonRoundTrip(std::move(vertices), bus, edges);
+				}
+
+			}
+
+			return edges;
+		}
+
+		/**
+		 * @brief Adds to a graph the cheapest edge of every (from, to) pair and drops the others.
+		 * All the edges of a pair pay the same wait, so the shortest road distance is the cheapest edge
+		 * whatever the route settings are, and the graph stays valid when the settings change.
+		 * On equal distances the edge spanning fewer stops wins, then the bus added first to the catalogue,
+		 * so the result does not depend on the order of the buses.
+		 * @param graph The graph the edges are added to.
+		 * @param edges The edges of all the buses.
+		 * @return The number of edges dropped.
+		 */
+		size_t TransportRouter::AddDominatingEdges(DirectedWeightedGraph<double>& graph, std::vector<Edge<double>> edges) {
+			const auto edge_key = [](const Edge<double>& edge) {
+				return std::make_tuple(edge.from, edge.to, edge.distance, uint32_t{ edge.span_count }, uint32_t{ edge.name_id });
+			};
+			std::sort(edges.begin(), edges.end(), [&edge_key](const Edge<double>& lhs, const Edge<double>& rhs) {
+				return edge_key(lhs) < edge_key(rhs);
+			});
+
+			size_t removed_edge_count = 0;
+			for (size_t i = 0; i < edges.size(); ++i) {
+				if (i > 0 && edges[i].from == edges[i - 1].from && edges[i].to == edges[i - 1].to) {
+					++removed_edge_count;
+					continue;
+				}
+				graph.AddEdge(edges[i]);
+			}
+			return removed_edge_count;
+		}
+
+		/**
+		 * @brief Computes the table weights of the edges of a graph, rounding the weights to tenths of a second.
+		 * Only the weights are converted: the all-pairs router reads the vertices of the edges from the graph itself.
+		 * @param graph The graph with the weights in minutes.
+		 * @return The weight of every edge by id, to build the all-pairs router with.
+		 * @throws std::out_of_range if a weight does not fit the table weight.
+		 */
+		std::vector<TableWeight> TransportRouter::ComputeTableWeights(const DirectedWeightedGraph<double>& graph) {
+			std::vector<TableWeight> table_weights;
+			table_weights.reserve(graph.GetEdgeCount());
+			for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+				const double weight = std::round(graph.GetEdge(edge_id).weight * TABLE_WEIGHTS_PER_MINUTE);
+				if (!(weight < static_cast<double>(TableRouter::UNREACHABLE_WEIGHT))) {
+					throw std::out_of_range("Edge weight doesn't fit the routes table");
+				}
+				table_weights.push_back(static_cast<TableWeight>(weight));
+			}
+			return table_weights;
+		}
+
+		/**
+		 * @brief Applies the current wait time and velocity of the catalogue without rebuilding the graph.
+		 * The edge weights are derived again from the stored road distances in linear time and the frozen layout is kept,
+		 * so the Dijkstra router reads the new weights as is and RAPTOR only recomputes its ride times.
+		 * The contraction hierarchy and the ALT landmarks are computed again over the reweighted graph,
+		 * and the all-pairs table is recomputed in memory; a mapped table file is released, as it holds the old weights.
+		 * The route cache is cleared.
+		 */
+		void TransportRouter::UpdateRouteSettings() {
+			if (route_cache_) {
+				SetRouteCacheCapacity(route_cache_->GetCapacity());
+			}
+			restricted_router_.reset();
+			if (raptor_router_) {
+				raptor_router_->SetRouteSettings(tc.GetWaitTime(), tc.GetVelocity());
+				return;
+			}
+
+			const double wait_time = tc.GetWaitTime();
+			const double velocity = tc.GetVelocity() * MINUTES_PER_KILOMETER;
+			graph_.Reweight([wait_time, velocity](const Edge<double>& edge) {
+				return wait_time + edge.distance / velocity;
+			});
+
+			if (contraction_hierarchy_) {
+				contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_);
+			}
+			else if (alt_router_) {
+				alt_router_ = std::make_unique<graph::AltRouter<double>>(graph_);
+			}
+			else if (router_) {
+				router_.reset();
+				mapped_router_table_.reset();
+				table_weights_ = ComputeTableWeights(graph_);
+				router_ = std::make_unique<graph::TableRouter>(graph_, table_weights_, vertex_components_);
+			}
+		}
+
+		/**
+		 * @brief Adds the edges of a bus of the catalogue to the graph without rebuilding the router.
+		 * @param bus_name The name of the bus, already added to the catalogue with its stops and distances.
+		 * @throws std::invalid_argument if the catalogue has no such bus.
+		 */
+		void TransportRouter::AddBus(std::string_view bus_name) {
+			const domain::Bus* bus = tc.FindBus(bus_name);
+			if (bus == nullptr) {
+				throw std::invalid_argument("unknown bus " + std::string(bus_name));
+			}
+			std::vector<bool> routed_buses = routed_buses_;
+			routed_buses.resize(tc.GetBuses().size(), false);
+			if (routed_buses[bus->id]) {
+				return;
+			}
+			routed_buses[bus->id] = true;
+			UpdateBuses(std::move(routed_buses), true);
+		}
+
+		/**
+		 * @brief Removes the edges of a bus from the graph without rebuilding the router.
+		 * @param bus_name The name of the bus.
+		 * @throws std::invalid_argument if the catalogue has no such bus.
+		 */
+		void TransportRouter::RemoveBus(std::string_view bus_name) {
+			const domain::Bus* bus = tc.FindBus(bus_name);
+			if (bus == nullptr) {
+				throw std::invalid_argument("unknown bus " + std::string(bus_name));
+			}
+			std::vector<bool> routed_buses = routed_buses_;
+			routed_buses.resize(tc.GetBuses().size(), false);
+			if (!routed_buses[bus->id]) {
+				return;
+			}
+			routed_buses[bus->id] = false;
+			UpdateBuses(std::move(routed_buses), false);
+		}
+
+		/**
+		 * @brief Rebuilds the graph for a new set of routed buses and updates the router.
+		 * Collecting the edges is linear, so the graph is built again with the vertices kept in place;
+		 * the stops served for the first time take the free vertices, or new ones appended to the graph.
+		 * Every old edge is matched with the new edge joining the same vertices. Adding a bus only brings new
+		 * or cheaper edges, which relax the all-pairs table; removing one drops edges, possibly uncovering
+		 * heavier parallel edges, and only the sources whose routes used a dropped edge are searched again.
+		 * The Dijkstra router is rebuilt over the new graph, RAPTOR, the contraction hierarchy and the ALT landmarks
+		 * are computed again. The route cache is cleared.
+		 * The new vertices and graph are computed aside. The routers refer to graph_ and table_weights_, so the new graph
+		 * and weights are swapped in while the router is updated and swapped back if that fails; the router stays consistent
+		 * with the old ones, and the other members only change once the update succeeded.
+		 * @param routed_buses Whether every bus by catalogue id is routed after the update.
+		 * @param is_bus_added Whether a bus was added; otherwise one was removed.
+		 */
+		void TransportRouter::UpdateBuses(std::vector<bool> routed_buses, bool is_bus_added) {
+			if (raptor_router_) {
+				raptor_router_ = std::make_unique<graph::RaptorRouter>(tc, routed_buses);
+			}
+			else {
+				VertexAssignment assignment = UpdateVertices(routed_buses);
+				DirectedWeightedGraph<double> graph(assignment.vertex_to_stop.size());
+				const size_t removed_edge_count = AddBusEdges(graph, assignment.stop_vertices, routed_buses);
+				graph.Freeze();
+				std::vector<uint32_t> components = graph::ComputeWeakComponents(graph);
+				std::vector<TableWeight> table_weights;
+				if (router_) {
+					table_weights = ComputeTableWeights(graph);
+				}
+
+				std::swap(graph_, graph);
+				const DirectedWeightedGraph<double>& old_graph = graph;
+				try {
+					if (dijkstra_router_) {
+						dijkstra_router_ = std::make_unique<graph::DijkstraRouter<double>>(graph_);
+					}
+					else if (contraction_hierarchy_) {
+						contraction_hierarchy_ = std::make_unique<graph::ContractionHierarchy<double>>(graph_);
+					}
+					else if (alt_router_) {
+						alt_router_ = std::make_unique<graph::AltRouter<double>>(graph_);
+					}
+					else if (router_) {
+						const auto edge_key = [](const Edge<double>& edge) {
+							return (static_cast<uint64_t>(edge.from) << 32) | edge.to;
+						};
+						std::unordered_map<uint64_t, EdgeId> new_edges;
+						new_edges.reserve(graph_.GetEdgeCount());
+						for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+							new_edges.emplace(edge_key(graph_.GetEdge(edge_id)), edge_id);
+						}
+
+						std::vector<uint32_t> edge_map(old_graph.GetEdgeCount(), TableRouter::NO_EDGE);
+						std::vector<bool> is_kept(graph_.GetEdgeCount(), false);
+						for (EdgeId edge_id = 0; edge_id < old_graph.GetEdgeCount(); ++edge_id) {
+							const Edge<double>& old_edge = old_graph.GetEdge(edge_id);
+							auto it = new_edges.find(edge_key(old_edge));
+							if (it == new_edges.end()) {
+								continue;
+							}
+							const Edge<double>& new_edge = graph_.GetEdge(it->second);
+							const bool is_same = new_edge.name_id == old_edge.name_id && new_edge.distance == old_edge.distance
+								&& new_edge.span_count == old_edge.span_count;
+							if (is_same || is_bus_added) {
+								edge_map[edge_id] = static_cast<uint32_t>(it->second);
+								is_kept[it->second] = is_same;
+							}
+						}
+
+						std::swap(table_weights_, table_weights);
+						try {
+							if (is_bus_added) {
+								std::vector<EdgeId> inserted_edges;
+								for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+									if (!is_kept[edge_id]) {
+										inserted_edges.push_back(edge_id);
+									}
+								}
+								router_->InsertEdges(components, edge_map, inserted_edges);
+							}
+							else {
+								router_->RemoveEdges(components, edge_map);
+							}
+						}
+						catch (...) {
+							std::swap(table_weights_, table_weights);
+							throw;
+						}
+						mapped_router_table_.reset();
+					}
+				}
+				catch (...) {
+					std::swap(graph_, graph);
+					throw;
+				}
+				stop_to_vertex_ = std::move(assignment.stop_to_vertex);
+				vertex_to_stop_ = std::move(assignment.vertex_to_stop);
+				vertex_components_ = std::move(components);
+				removed_edge_count_ = removed_edge_count;
+			}
+
+			routed_buses_ = std::move(routed_buses);
+			restricted_router_.reset();
+			if (route_cache_) {
+				SetRouteCacheCapacity(route_cache_->GetCapacity());
+			}
+		}
+
+		/**
+		 * @brief Retrieves the number of parallel edges dropped while building the graph.
+		 * @return The number of edges dropped by AddKnots.
+		 */
+		size_t TransportRouter::GetRemovedEdgeCount() const {
+			return removed_edge_count_;
+		}
+
+		/**
+		 * @brief Computes the fingerprint of the graph and the route settings, identifying the all-pairs table written for them.
+		 * @return The fingerprint stored in the base and in the routes table file.
+		 */
+		uint64_t TransportRouter::GetRouterTableFingerprint() const {
+			return ComputeRouterTableFingerprint(graph_, tc.GetWaitTime(), tc.GetVelocity());
+		}
+
+		/**
+		 * @brief Retrieves the buses whose edges are in the graph.
+		 * @return Whether every bus by catalogue id is routed; the buses added to the catalogue since are not.
+		 */
+		const std::vector<bool>& TransportRouter::GetRoutedBuses() const {
+			return routed_buses_;
 		}
 
 		/**
 		 * @brief Calculates the route and buses between two stops.
 		 * This function calculates the route and buses between the specified starting and destination stops.
-		 * It uses the Router to find the shortest route in the graph.
-		 * The result includes a vector of variant types representing bus activities and waiting activities in the route.
+		 * When the route cache is enabled, a repeated pair of stops is answered from the cache without searching
+		 * or rebuilding the activities; routes that do not exist are cached as well.
 		 * @param stop_name_from The name of the starting stop.
 		 * @param stop_name_to The name of the destination stop.
 		 * @return An optional DestinationInfo structure with the calculated route and buses, or std::nullopt if the stops are not found.
 		 */
 		std::optional<DestinationInfo> TransportRouter::GetRouteAndBuses(std::string_view stop_name_from, std::string_view stop_name_to) {
-			DestinationInfo dest_info;
-			std::vector<std::variant<graph::BusActivity, graph::WaitingActivity>> final_route;
+			if (!route_cache_) {
+				return FindRouteAndBuses(stop_name_from, stop_name_to);
+			}
+
+			const domain::Stop* stop_from = tc.FindStop(stop_name_from);
+			const domain::Stop* stop_to = tc.FindStop(stop_name_to);
+			if (stop_from == nullptr || stop_to == nullptr) {
+				return std::nullopt;
+			}
+			const uint64_t key = (static_cast<uint64_t>(stop_from->id) << 32) | stop_to->id;
+			if (const std::optional<DestinationInfo>* cached = route_cache_->Find(key)) {
+				return *cached;
+			}
+
+			std::optional<DestinationInfo> route = FindRouteAndBuses(stop_name_from, stop_name_to);
+			route_cache_->Insert(key, route);
+			return route;
+		}
+
+		/**
+		 * @brief Finds the route and buses between two stops avoiding some stops and buses within a time limit and a compute budget.
+		 * A request with limits only is answered by the selected router, whose search stops once its frontier exceeds the time limit.
+		 * The graph keeps only the fastest of the parallel rides between two stops, so masking the edges of a bus
+		 * would lose the rides of the other buses it dominates. A restricted request is therefore answered by
+		 * a RAPTOR search over the bus stop sequences with bitmasks over the stops and the buses, which finds
+		 * the times of the graph when nothing is avoided. Requests without restrictions keep the selected router and the route cache.
+		 * @param stop_name_from The name of the starting stop.
+		 * @param stop_name_to The name of the destination stop.
+		 * @param restrictions The stops and buses to avoid and the bounds of the search.
+		 * @return The route, or std::nullopt if the route is not found within the time limit or either stop is avoided.
+		 * @throws SearchTimeoutError if the search runs out of its compute budget.
+		 */
+		std::optional<DestinationInfo> TransportRouter::GetRouteAndBuses(std::string_view stop_name_from, std::string_view stop_name_to,
+		                                                                 const RouteRestrictions& restrictions) {
+			if (restrictions.IsEmpty()) {
+				return GetRouteAndBuses(stop_name_from, stop_name_to);
+			}
+			graph::SearchLimits<double> limits{ restrictions.max_time, std::nullopt };
+			if (restrictions.compute_budget) {
+				limits.deadline = std::chrono::steady_clock::now() + *restrictions.compute_budget;
+			}
+			if (!restrictions.HasExclusions()) {
+				return FindRouteAndBuses(stop_name_from, stop_name_to, limits);
+			}
+
+			const graph::RaptorRouter& raptor_router = GetRestrictedRouter();
+			std::optional<uint32_t> from = raptor_router.GetStopIndex(stop_name_from);
+			std::optional<uint32_t> to = raptor_router.GetStopIndex(stop_name_to);
+			if (!from || !to) {
+				return std::nullopt;
+			}
+
+			graph::RaptorRouter::Exclusions exclusions{ std::vector<bool>(tc.GetStops().size(), false),
+			                                            std::vector<bool>(tc.GetBuses().size(), false) };
+			for (std::string_view stop_name : restrictions.avoid_stops) {
+				if (const domain::Stop* stop = tc.FindStop(stop_name)) {
+					exclusions.stops[stop->id] = true;
+				}
+			}
+			for (std::string_view bus_name : restrictions.avoid_buses) {
+				if (const domain::Bus* bus = tc.FindBus(bus_name)) {
+					exclusions.buses[bus->id] = true;
+				}
+			}
+
+			std::optional<graph::RaptorRouter::RouteInfo> route_info = raptor_router.BuildRoute(*from, *to, exclusions, limits);
+			if (!route_info) {
+				return std::nullopt;
+			}
+			return MakeDestinationInfo(raptor_router, *route_info);
+		}
+
+		/**
+		 * @brief Retrieves the RAPTOR router answering the restricted route requests.
+		 * With another engine it is built from the routed buses on the first call, in linear time and memory,
+		 * and dropped whenever the buses or the route settings change.
+		 * @return The RAPTOR router.
+		 */
+		const graph::RaptorRouter& TransportRouter::GetRestrictedRouter() {
+			if (raptor_router_) {
+				return *raptor_router_;
+			}
+			if (!restricted_router_) {
+				routed_buses_.resize(tc.GetBuses().size(), false);
+				restricted_router_ = std::make_unique<graph::RaptorRouter>(tc, routed_buses_);
+			}
+			return *restricted_router_;
+		}
+
+		/**
+		 * @brief Enables the route cache of GetRouteAndBuses, dropping the cached routes.
+		 * @param capacity The maximum number of cached routes. Zero disables the cache.
+		 */
+		void TransportRouter::SetRouteCacheCapacity(size_t capacity) {
+			route_cache_ = capacity > 0 ? std::make_unique<RouteCache>(capacity) : nullptr;
+		}
+
+		/**
+		 * @brief Retrieves the route cache.
+		 * @return The route cache, or nullptr if it is disabled.
+		 */
+		const TransportRouter::RouteCache* TransportRouter::GetRouteCache() const {
+			return route_cache_.get();
+		}
+
+		/**
+		 * @brief Finds the route and buses between two stops with the selected router, bypassing the route cache.
+		 * It uses the Router to find the shortest route in the graph.
+		 * The result includes a vector of variant types representing bus activities and waiting activities in the route.
+		 * @param stop_name_from The name of the starting stop.
+		 * @param stop_name_to The name of the destination stop.
+		 * @param limits The bounds of the search.
+		 * @return The route, or std::nullopt if the stops are not found or the route does not exist within the time limit.
+		 */
+		std::optional<DestinationInfo> TransportRouter::FindRouteAndBuses(std::string_view stop_name_from, std::string_view stop_name_to,
+		                                                                  const SearchLimits<double>& limits) {
+			if (raptor_router_) {
+				std::optional<uint32_t> from = raptor_router_->GetStopIndex(stop_name_from);
+				std::optional<uint32_t> to = raptor_router_->GetStopIndex(stop_name_to);
+				if (!from || !to) {
+					return std::nullopt;
+				}
+				std::optional<graph::RaptorRouter::RouteInfo> route_info = raptor_router_->BuildRoute(*from, *to, limits);
+				if (!route_info) {
+					return std::nullopt;
+				}
+				return MakeDestinationInfo(*raptor_router_, *route_info);
+			}
+
 			size_t from;
 			size_t to;
 			if (!ChekExistValue(stop_name_from) || !ChekExistValue(stop_name_to)) {
@@ -69,49 +692,364 @@ namespace graph {
 			from = stop_to_vertex_.find(stop_name_from)->second;
 			to = stop_to_vertex_.find(stop_name_to)->second;
 
-			std::optional<typename graph::Router<double>::RouteInfo> route_info = router_->BuildRoute(from, to);
+			std::optional<typename graph::Router<double>::RouteInfo> route_info = BuildRoute(from, to, limits);
 
-			double wait_time = tc.GetWaitTime();
+			if (route_info.has_value()) {
+				return MakeDestinationInfo(route_info.value());
+			}
+			else {
+				return std::nullopt;
+			}
 
-			std::set<std::string> actual_buses;
-			std::set<std::string> buses_for_route_first_stop;
-			std::set<std::string> buses_for_route_second_stop;
+		}
 
-			if (route_info.has_value()) {
-				const auto& route_info_value = route_info.value();
+		/**
+		 * @brief Calculates the routes from one stop to several stops.
+		 * With the Dijkstra and RAPTOR engines all the routes come from a single search, so the cost depends on the origin only.
+		 * The other engines answer every destination separately: a table lookup or a single guided search.
+		 * Destinations outside the component of the origin are answered without searching.
+		 * @param stop_name_from The name of the starting stop.
+		 * @param stop_names_to The names of the destination stops.
+		 * @return The routes in the order of the destination stops; std::nullopt for unknown stops or missing routes.
+		 */
+		std::vector<std::optional<DestinationInfo>> TransportRouter::GetRoutesAndBuses(std::string_view stop_name_from, const std::vector<std::string_view>& stop_names_to) {
+			std::vector<std::optional<DestinationInfo>> destinations(stop_names_to.size());
+			if (raptor_router_) {
+				std::optional<uint32_t> from = raptor_router_->GetStopIndex(stop_name_from);
+				if (!from) {
+					return destinations;
+				}
+				std::vector<size_t> destination_indexes;
+				std::vector<uint32_t> to;
+				for (size_t i = 0; i < stop_names_to.size(); ++i) {
+					if (std::optional<uint32_t> stop = raptor_router_->GetStopIndex(stop_names_to[i])) {
+						destination_indexes.push_back(i);
+						to.push_back(*stop);
+					}
+				}
+				std::vector<std::optional<graph::RaptorRouter::RouteInfo>> route_infos = raptor_router_->BuildRoutes(*from, to);
+				for (size_t i = 0; i < route_infos.size(); ++i) {
+					if (route_infos[i]) {
+						destinations[destination_indexes[i]] = MakeDestinationInfo(*raptor_router_, *route_infos[i]);
+					}
+				}
+				return destinations;
+			}
 
-				for (auto it = route_info_value.edges.begin(); it != route_info_value.edges.end(); ++it) {
-					auto EdgId = *it;
-					auto Edge = graph_.GetEdge(EdgId);
-					if (Edge.stop_count == 0) {
-						WaitingActivity wa;
-						wa.time = wait_time;
-						wa.stop_name_from = Edge.name;
+			std::optional<size_t> from = GetValueByKey(stop_name_from);
+			if (!from) {
+				return destinations;
+			}
 
-						final_route.push_back(wa);
-						dest_info.all_time += wait_time;
+			std::vector<size_t> destination_indexes;
+			std::vector<VertexId> to;
+			for (size_t i = 0; i < stop_names_to.size(); ++i) {
+				std::optional<size_t> vertex = GetValueByKey(stop_names_to[i]);
+				if (vertex && vertex_components_[*vertex] == vertex_components_[*from]) {
+					destination_indexes.push_back(i);
+					to.push_back(*vertex);
+				}
+			}
 
-					}
+			std::vector<std::optional<graph::Router<double>::RouteInfo>> route_infos;
+			if (dijkstra_router_) {
+				route_infos = dijkstra_router_->BuildRoutes(*from, to);
+			}
+			else {
+				for (const VertexId vertex : to) {
+					route_infos.push_back(BuildRoute(*from, vertex));
+				}
+			}
 
-					else {
-						BusActivity ba;
-						ba.bus_name = Edge.name;
-						ba.time = Edge.weight;
-						ba.span_count = Edge.stop_count;
-						final_route.push_back(ba);
-						dest_info.all_time += Edge.weight;
+			for (size_t i = 0; i < route_infos.size(); ++i) {
+				if (route_infos[i]) {
+					destinations[destination_indexes[i]] = MakeDestinationInfo(*route_infos[i]);
+				}
+			}
+			return destinations;
+		}
+
+		/**
+		 * @brief Computes the total times between every origin and every destination stop without building the routes.
+		 * No route is reconstructed and the activities are not built. The all-pairs router reads its table,
+		 * whose times are converted from tenths of a second,
+		 * the contraction hierarchy runs its bucket-based many-to-many search and RAPTOR runs one set of rounds per origin.
+		 * The other routers run one Dijkstra search per origin, limited to the destinations in the component of the origin;
+		 * the ALT landmarks only help point-to-point queries.
+		 * @param stop_names_from The names of the origin stops.
+		 * @param stop_names_to The names of the destination stops.
+		 * @return The times by origin, then destination; std::nullopt where a stop is not found or the route does not exist.
+		 */
+		std::vector<std::vector<std::optional<double>>> TransportRouter::GetRouteMatrix(const std::vector<std::string_view>& stop_names_from,
+		                                                                                const std::vector<std::string_view>& stop_names_to) {
+			std::vector<std::vector<std::optional<double>>> matrix(stop_names_from.size(), std::vector<std::optional<double>>(stop_names_to.size()));
 
+			const auto resolve = [this](const std::vector<std::string_view>& stop_names, std::vector<size_t>& indexes, std::vector<uint32_t>& ids) {
+				for (size_t i = 0; i < stop_names.size(); ++i) {
+					std::optional<size_t> id;
+					if (raptor_router_) {
+						id = raptor_router_->GetStopIndex(stop_names[i]);
 					}
+					else {
+						id = GetValueByKey(stop_names[i]);
+					}
+					if (id) {
+						indexes.push_back(i);
+						ids.push_back(static_cast<uint32_t>(*id));
+					}
+				}
+			};
+			std::vector<size_t> from_indexes;
+			std::vector<uint32_t> from;
+			resolve(stop_names_from, from_indexes, from);
+			std::vector<size_t> to_indexes;
+			std::vector<uint32_t> to;
+			resolve(stop_names_to, to_indexes, to);
+
+			const auto fill_row = [&](size_t row, const std::vector<std::optional<double>>& weights) {
+				for (size_t i = 0; i < weights.size(); ++i) {
+					matrix[from_indexes[row]][to_indexes[i]] = weights[i];
+				}
+			};
 
+			if (raptor_router_) {
+				for (size_t row = 0; row < from.size(); ++row) {
+					fill_row(row, raptor_router_->BuildRouteWeights(from[row], to));
 				}
-				dest_info.route = final_route;
+				return matrix;
+			}
 
-				return dest_info;
+			const std::vector<VertexId> to_vertices(to.begin(), to.end());
+			if (router_) {
+				for (size_t row = 0; row < from.size(); ++row) {
+					for (size_t i = 0; i < to_vertices.size(); ++i) {
+						if (std::optional<TableWeight> weight = router_->GetRouteWeight(from[row], to_vertices[i])) {
+							matrix[from_indexes[row]][to_indexes[i]] = *weight / TABLE_WEIGHTS_PER_MINUTE;
+						}
+					}
+				}
+			}
+			else if (contraction_hierarchy_) {
+				const std::vector<VertexId> from_vertices(from.begin(), from.end());
+				const std::vector<std::vector<std::optional<double>>> weights = contraction_hierarchy_->BuildWeightMatrix(from_vertices, to_vertices);
+				for (size_t row = 0; row < from.size(); ++row) {
+					fill_row(row, weights[row]);
+				}
 			}
 			else {
-				return std::nullopt;
+				std::optional<DijkstraRouter<double>> local_dijkstra_router;
+				const DijkstraRouter<double>* dijkstra_router = dijkstra_router_.get();
+				if (dijkstra_router == nullptr) {
+					dijkstra_router = &local_dijkstra_router.emplace(graph_);
+				}
+				for (size_t row = 0; row < from.size(); ++row) {
+					std::vector<size_t> component_indexes;
+					std::vector<VertexId> component_vertices;
+					for (size_t i = 0; i < to_vertices.size(); ++i) {
+						if (vertex_components_[to_vertices[i]] == vertex_components_[from[row]]) {
+							component_indexes.push_back(i);
+							component_vertices.push_back(to_vertices[i]);
+						}
+					}
+					if (component_vertices.empty()) {
+						continue;
+					}
+					const std::vector<std::optional<double>> weights = dijkstra_router->BuildRouteWeights(from[row], component_vertices);
+					for (size_t i = 0; i < weights.size(); ++i) {
+						matrix[from_indexes[row]][to_indexes[component_indexes[i]]] = weights[i];
+					}
+				}
 			}
+			return matrix;
+		}
 
+		/**
+		 * @brief Finds every stop reachable from a stop within a time budget with one bounded search.
+		 * The graph routers share a bounded Dijkstra search over the graph; RAPTOR bounds its rounds instead.
+		 * @param stop_name_from The name of the starting stop.
+		 * @param max_time The time budget in minutes.
+		 * @return The reachable stops, the starting stop included, ordered by time and then by name;
+		 * std::nullopt if the stop is not found.
+		 */
+		std::optional<std::vector<ReachableStop>> TransportRouter::GetReachableStops(std::string_view stop_name_from, double max_time) {
+			std::vector<ReachableStop> reachable_stops;
+			if (raptor_router_) {
+				std::optional<uint32_t> from = raptor_router_->GetStopIndex(stop_name_from);
+				if (!from) {
+					return std::nullopt;
+				}
+				for (const auto& [stop, time] : raptor_router_->BuildReachable(*from, max_time)) {
+					reachable_stops.push_back({ raptor_router_->GetStopName(stop), time });
+				}
+			}
+			else {
+				std::optional<size_t> from = GetValueByKey(stop_name_from);
+				if (!from) {
+					return std::nullopt;
+				}
+				std::optional<DijkstraRouter<double>> local_dijkstra_router;
+				const DijkstraRouter<double>* dijkstra_router = dijkstra_router_.get();
+				if (dijkstra_router == nullptr) {
+					dijkstra_router = &local_dijkstra_router.emplace(graph_);
+				}
+				const std::deque<domain::Stop>& stops = tc.GetStops();
+				for (const auto& [vertex, time] : dijkstra_router->BuildReachable(*from, max_time)) {
+					reachable_stops.push_back({ stops[vertex_to_stop_[vertex]].stop_name, time });
+				}
+			}
+
+			std::sort(reachable_stops.begin(), reachable_stops.end(), [](const ReachableStop& lhs, const ReachableStop& rhs) {
+				return std::tie(lhs.time, lhs.stop_name) < std::tie(rhs.time, rhs.stop_name);
+			});
+			return reachable_stops;
+		}
+
+		/**
+		 * @brief Converts the edges of a route to the waiting and bus activities.
+		 * Every edge is a boarding: it gives the wait at its source stop and the ride, whose time is the edge weight
+		 * without the wait time. The stop and bus names are looked up in the catalogue by id and referred to, not copied.
+		 * @param route_info The route found by the router.
+		 * @return The DestinationInfo structure with the activities and the total time.
+		 */
+		DestinationInfo TransportRouter::MakeDestinationInfo(const graph::Router<double>::RouteInfo& route_info) const {
+			DestinationInfo dest_info;
+			dest_info.route.reserve(2 * route_info.edges.size());
+			const double wait_time = tc.GetWaitTime();
+			const std::deque<domain::Stop>& stops = tc.GetStops();
+			const std::deque<domain::Bus>& buses = tc.GetBuses();
+
+			for (const EdgeId edge_id : route_info.edges) {
+				const auto& edge = graph_.GetEdge(edge_id);
+				dest_info.route.emplace_back(WaitingActivity{ stops[vertex_to_stop_[edge.from]].stop_name, wait_time });
+				dest_info.route.emplace_back(BusActivity{ buses[edge.name_id].bus_name, edge.weight - wait_time, static_cast<int>(edge.span_count) });
+				dest_info.all_time += edge.weight;
+			}
+
+			return dest_info;
+		}
+
+		/**
+		 * @brief Converts the rides of a RAPTOR route to the waiting and bus activities.
+		 * Every ride starts with the wait at its boarding stop, as the wait edges of the graph do.
+		 * @param raptor_router The RAPTOR router that found the route.
+		 * @param route_info The route found by the RAPTOR router.
+		 * @return The DestinationInfo structure with the activities and the total time.
+		 */
+		DestinationInfo TransportRouter::MakeDestinationInfo(const graph::RaptorRouter& raptor_router, const graph::RaptorRouter::RouteInfo& route_info) const {
+			DestinationInfo dest_info;
+			dest_info.route.reserve(2 * route_info.legs.size());
+			const double wait_time = raptor_router.GetWaitTime();
+
+			for (const graph::RaptorRouter::Leg& leg : route_info.legs) {
+				WaitingActivity wa;
+				wa.stop_name_from = raptor_router.GetStopName(leg.route, leg.board_position);
+				wa.time = wait_time;
+				dest_info.route.push_back(wa);
+				dest_info.all_time += wait_time;
+
+				BusActivity ba;
+				ba.bus_name = raptor_router.GetBusName(leg.route);
+				ba.time = raptor_router.GetRideTime(leg);
+				ba.span_count = static_cast<int>(leg.alight_position - leg.board_position);
+				dest_info.route.push_back(ba);
+				dest_info.all_time += ba.time;
+			}
+
+			return dest_info;
+		}
+
+		/**
+		 * @brief Retrieves the graph built from the bus routes.
+		 * @return The directed weighted graph.
+		 */
+		const DirectedWeightedGraph<double>& TransportRouter::GetGraph() const {
+			return graph_;
+		}
+
+		/**
+		 * @brief Retrieves the vertices of the stops served by buses.
+		 * The stops are identified by their index in TransportCatalogue::GetStops().
+		 * @return Pairs of stop index in the catalogue and its vertex, in catalogue order.
+		 */
+		std::vector<std::pair<size_t, VertexId>> TransportRouter::GetStopVertices() const {
+			std::vector<std::pair<size_t, VertexId>> stop_vertices;
+			const std::deque<domain::Stop>& stops = tc.GetStops();
+			for (size_t stop_index = 0; stop_index < stops.size(); ++stop_index) {
+				auto it = stop_to_vertex_.find(stops[stop_index].stop_name);
+				if (it != stop_to_vertex_.end()) {
+					stop_vertices.emplace_back(stop_index, it->second);
+				}
+			}
+			return stop_vertices;
+		}
+
+		/**
+		 * @brief Retrieves the weakly connected components of the graph.
+		 * @return The component label of every vertex.
+		 */
+		const std::vector<uint32_t>& TransportRouter::GetVertexComponents() const {
+			return vertex_components_;
+		}
+
+		/**
+		 * @brief Retrieves the all-pairs router.
+		 * @return The router, or nullptr if another router engine is used.
+		 */
+		const TableRouter* TransportRouter::GetRouter() const {
+			return router_.get();
+		}
+
+		/**
+		 * @brief Retrieves the contraction hierarchy.
+		 * @return The contraction hierarchy, or nullptr if another router engine is used.
+		 */
+		const ContractionHierarchy<double>* TransportRouter::GetContractionHierarchy() const {
+			return contraction_hierarchy_.get();
+		}
+
+		/**
+		 * @brief Retrieves the ALT router.
+		 * @return The ALT router, or nullptr if another router engine is used.
+		 */
+		const AltRouter<double>* TransportRouter::GetAltRouter() const {
+			return alt_router_.get();
+		}
+
+		/**
+		 * @brief Builds the route between two vertices with the router selected in the route settings.
+		 * Vertices of different weakly connected components are never joined by a route, so no search is run for them.
+		 * A route taken from the all-pairs table gets its weight back in minutes from the edges of graph_
+		 * and is checked against the time limit only then, as the table lookup costs no search.
+		 * @param from The starting vertex.
+		 * @param to The destination vertex.
+		 * @param limits The bounds of the search.
+		 * @return The route info, or std::nullopt if the route is not found within the time limit.
+		 */
+		std::optional<graph::Router<double>::RouteInfo> TransportRouter::BuildRoute(VertexId from, VertexId to, const SearchLimits<double>& limits) const {
+			if (vertex_components_[from] != vertex_components_[to]) {
+				return std::nullopt;
+			}
+			if (dijkstra_router_) {
+				return dijkstra_router_->BuildRoute(from, to, limits);
+			}
+			if (contraction_hierarchy_) {
+				return contraction_hierarchy_->BuildRoute(from, to, limits);
+			}
+			if (alt_router_) {
+				return alt_router_->BuildRoute(from, to, limits);
+			}
+			std::optional<graph::TableRouter::RouteInfo> table_route_info = router_->BuildRoute(from, to);
+			if (!table_route_info) {
+				return std::nullopt;
+			}
+			double weight = 0.0;
+			for (const EdgeId edge_id : table_route_info->edges) {
+				weight += graph_.GetEdge(edge_id).weight;
+			}
+			if (limits.max_weight && *limits.max_weight < weight) {
+				return std::nullopt;
+			}
+			return graph::Router<double>::RouteInfo{ weight, std::move(table_route_info->edges) };
 		}
 
 		/**
@@ -149,86 +1087,35 @@ namespace graph {
 
 		/**
 		 * @brief Adds stops to the graph in one direction for a given bus.
-		 * This function adds stops to the graph in one direction for a given bus.
-		 * It creates vertex indices for the stops and connects them with edges representing the bus route.
-		 * @param stops The deque of stop names in the bus route.
-		 * @param bus_name The name of the bus.
+		 * This function collects the edges of one direction of a given bus.
+		 * Every stop is a single vertex. An edge goes from every stop to every later stop of the bus,
+		 * and its weight is the bus wait time at the boarding stop plus the ride time.
+		 * The road distance of the edge is kept with it, so the weight can be derived again for other settings.
+		 * Ride distances come from the prefix sums of the bus, so no stop is looked up by name here.
+		 * The edges keep the catalogue id of the bus instead of its name.
+		 * @param vertices The vertices of the stops in the order of this direction.
+		 * @param prefix_sums The prefix sums of the distances in the order of this direction.
+		 * @param bus_id The catalogue id of the bus.
+		 * @param edges The edges the new ones are appended to.
+		 * @throws std::length_error if the bus id, the stop count or a road distance does not fit an edge.
 		 */
-		void TransportRouter::AddStopsOneDirection(const std::deque<std::string_view>& stops, const std::string& bus_name) {
-
-			for (auto it = stops.begin(); std::next(it) != stops.end(); ++it) {
-				double sum_time = 0;
-				size_t num_vertex_1_wait;
-				size_t num_vertex_next_wait;
-
-				if (ChekExistValue(*it)) {
-					auto indx = stop_to_vertex_.find(*it);
-					num_vertex_1_wait = indx->second;
-				}
-				else {
-					num_vertex_1_wait = stop_to_vertex_.size() * 2;
-					stop_to_vertex_.insert({ *it , num_vertex_1_wait });
-
-				}
-
-				if (ChekExistValue(*std::next(it))) {
-					auto indx = stop_to_vertex_.find(*std::next(it));
-					num_vertex_next_wait = indx->second;
-				}
-				else {
-					num_vertex_next_wait = stop_to_vertex_.size() * 2;
-					stop_to_vertex_.insert({ *std::next(it), num_vertex_next_wait });
-
-				}
-
-
-
-				size_t num_vertex1_go = num_vertex_1_wait + 1;
-
-
-				const domain::Stop* stop_1 = tc.FindStop(*it);
-				const domain::Stop* stop_1_next = tc.FindStop(*std::next(it));
-				int distance_inner = tc.GetStopDistance(*stop_1, *stop_1_next);
-				double time_inner = distance_inner / (tc.GetVelocity() * MINUTES_PER_KILOMETER) + sum_time;
-
-				Edge<double>* edge_mirror = new Edge<double>{ num_vertex_1_wait, num_vertex1_go, tc.GetWaitTime() , std::string(*it), 0 }; 
-				Edge<double>* edge_go_wait = new Edge<double>{ num_vertex1_go, num_vertex_next_wait, time_inner, bus_name, 1 };
-
-				graph_.AddEdge(*edge_mirror);
-
-				graph_.AddEdge(*edge_go_wait);
-
-				sum_time = time_inner;
-
-				for (auto it_inner = std::next(it); std::next(it_inner) != stops.end(); ++it_inner) {
-
-					size_t num_vertex_inner_next_wait;
-					if (ChekExistValue(*std::next(it_inner))) {
-						auto indx = stop_to_vertex_.find(*std::next(it_inner));
-						num_vertex_inner_next_wait = indx->second;
-					}
-					else {
-						num_vertex_inner_next_wait = stop_to_vertex_.size() * 2;
-						stop_to_vertex_.insert({ *std::next(it_inner), num_vertex_inner_next_wait });
+		void TransportRouter::AddStopsOneDirection(const std::vector<size_t>& vertices, const domain::RoutePrefixSums& prefix_sums,
+		                                           uint32_t bus_id, std::vector<Edge<double>>& edges) const {
+			const double wait_time = tc.GetWaitTime();
+			const double velocity = tc.GetVelocity() * MINUTES_PER_KILOMETER;
+			const std::vector<int64_t>& road_distances = prefix_sums.road_distances;
+			if (bus_id > Edge<double>::MAX_NAME_ID || vertices.size() > Edge<double>::MAX_SPAN_COUNT) {
+				throw std::length_error("Bus doesn't fit the router graph edges");
+			}
 
+			for (size_t from = 0; from + 1 < vertices.size(); ++from) {
+				for (size_t to = from + 1; to < vertices.size(); ++to) {
+					const int64_t distance = road_distances[to] - road_distances[from];
+					if (distance < 0 || distance > std::numeric_limits<uint32_t>::max()) {
+						throw std::length_error("Road distance doesn't fit the router graph edges");
 					}
-
-
-
-					const domain::Stop* stop_inner = tc.FindStop(*it_inner);
-					const domain::Stop* stop_inner_next = tc.FindStop(*(std::next(it_inner)));
-					int distance_1_2 = tc.GetStopDistance(*stop_inner, *stop_inner_next);
-
-
-					double time_min_1_2 = distance_1_2 / (tc.GetVelocity() * MINUTES_PER_KILOMETER) + sum_time;
-
-					int span_count = std::distance(stops.begin(), std::next(it_inner)) - std::distance(stops.begin(), it);
-
-					Edge<double>* edge_go_wait_inner = new Edge<double>{ num_vertex1_go, num_vertex_inner_next_wait , time_min_1_2, bus_name, span_count };
-
-					graph_.AddEdge(*edge_go_wait_inner);
-					sum_time = time_min_1_2;
-
+					edges.push_back({ static_cast<uint32_t>(vertices[from]), static_cast<uint32_t>(vertices[to]), wait_time + distance / velocity,
+					                  bus_id, static_cast<uint32_t>(to - from), static_cast<uint32_t>(distance) });
 				}
 			}
 
@@ -238,13 +1125,14 @@ namespace graph {
 		 * @brief Adds stops to the graph in both directions for a given bus.
 		 * This function adds stops to the graph in both directions for a given bus.
 		 * It first adds the stops in one direction and then reverses the order and adds them again.
-		 * @param stops The deque of stop names in the bus route.
-		 * @param bus_name The name of the bus.
+		 * @param vertices The vertices of the stops in the order of the bus stops.
+		 * @param bus The bus.
+		 * @param edges The edges the new ones are appended to.
 		 */
-		void TransportRouter::AddStopsNonRoundTrip(std::deque<std::string_view> stops, const std::string& bus_name) {
-			AddStopsOneDirection(stops, bus_name);
-			std::reverse(stops.begin(), stops.end());
-			AddStopsOneDirection(stops, bus_name);
+		void TransportRouter::AddStopsNonRoundTrip(std::vector<size_t> vertices, const domain::Bus& bus, std::vector<Edge<double>>& edges) const {
+			AddStopsOneDirection(vertices, bus.forward, bus.id, edges);
+			std::reverse(vertices.begin(), vertices.end());
+			AddStopsOneDirection(vertices, bus.backward, bus.id, edges);
 
 		}
 	
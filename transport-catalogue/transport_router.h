@@ -4,8 +4,16 @@
  * @brief This file contains the declaration of the TransportRouter class and related structs.
  */
 #include "router.h"
+#include "dijkstra_router.h"
+#include "contraction_hierarchy.h"
+#include "alt_router.h"
+#include "raptor_router.h"
+#include "router_table_file.h"
+#include "lru_cache.h"
 #include "transport_catalogue.h"
 
+#include <chrono>
+#include <cstdint>
 #include <variant>
 #include <memory>
 
@@ -15,7 +23,7 @@ namespace graph {
      * @brief Struct representing a bus activity in the route.
      */
     struct BusActivity {
-        std::string bus_name; /**< The name of the bus */
+        std::string_view bus_name; /**< The name of the bus, owned by the catalogue */
         double time; /**< The time spent on the bus activity */
         int span_count; /**< The number of stops spanned by the bus activity */
     };
@@ -25,19 +33,65 @@ namespace graph {
      * @brief Struct representing a waiting activity at a stop.
      */
     struct WaitingActivity {
-        std::string stop_name_from; /**< The name of the stop where the waiting activity occurs */
+        std::string_view stop_name_from; /**< The name of the stop where the waiting activity occurs, owned by the catalogue */
         double time; /**< The time spent on the waiting activity */
     };
 
     /**
      * @struct DestinatioInfo
      * @brief Struct representing the destination information, including the route and total time.
+     * The activities refer to the names held by the catalogue, so building a route copies no string.
      */
     struct DestinationInfo {
         std::vector<std::variant<BusActivity, WaitingActivity>> route; /**< The route with bus activities and waiting activities */
         double all_time = 0.0; /**< The total time of the destination */
     };
 
+    /**
+     * @struct RouteRestrictions
+     * @brief Struct representing the stops and buses a route request must avoid and the bounds of its search.
+     * An avoided stop is neither boarded nor alighted at, though the buses still pass it. Unknown names are ignored.
+     */
+    struct RouteRestrictions {
+        std::vector<std::string_view> avoid_stops; /**< The names of the closed stops */
+        std::vector<std::string_view> avoid_buses; /**< The names of the suspended buses */
+        std::optional<double> max_time; /**< The longest acceptable total time in minutes */
+        std::optional<std::chrono::steady_clock::duration> compute_budget; /**< The longest acceptable search time */
+
+        bool HasExclusions() const {
+            return !avoid_stops.empty() || !avoid_buses.empty();
+        }
+
+        bool IsEmpty() const {
+            return !HasExclusions() && !max_time && !compute_budget;
+        }
+    };
+
+    /**
+     * @struct ReachableStop
+     * @brief Struct representing a stop reachable within a time budget.
+     */
+    struct ReachableStop {
+        std::string_view stop_name; /**< The name of the stop */
+        double time; /**< The time of the fastest route to the stop */
+    };
+
+    /**
+     * @struct TransportRouterData
+     * @brief Struct holding the precomputed state of a TransportRouter, as stored in the serialized base.
+     */
+    struct TransportRouterData {
+        DirectedWeightedGraph<double> graph; /**< The graph built from the bus routes */
+        std::vector<std::pair<size_t, VertexId>> stop_vertices; /**< Pairs of stop index in the catalogue and its vertex */
+        std::vector<uint32_t> vertex_components; /**< The weakly connected component of every vertex, empty if it was not stored */
+        std::optional<TableRouter::RoutesInternalData> routes_internal_data; /**< The all-pairs table, if it was stored in the base */
+        std::string router_table_file; /**< The file with the all-pairs table, if it was stored outside the base */
+        MapAdvice router_table_advice = MapAdvice::NORMAL; /**< The hint for mapping router_table_file */
+        uint64_t router_table_fingerprint = 0; /**< The fingerprint router_table_file must carry */
+        std::optional<ContractionHierarchy<double>::Preprocessing> contraction_hierarchy; /**< The contraction hierarchy, if it was stored in the base */
+        std::optional<AltRouter<double>::Landmarks> landmarks; /**< The ALT landmarks, if they were stored in the base */
+    };
+
         /**
          * @class TransportRouter
          * @brief Class responsible for processing activities and finding routes between stops.
@@ -48,14 +102,51 @@ namespace graph {
             /**
              * @brief Constructor for the TransportRouter class.
              * @param tc The transport catalogue containing bus and stop information.
+             * @param routed_buses Whether every bus by catalogue id is routed; empty to route all the buses.
+             */
+            TransportRouter(transport_catalogue::TransportCatalogue& tc, std::vector<bool> routed_buses = {});
+
+            /**
+             * @brief Constructor restoring the TransportRouter from the precomputed data without rebuilding the graph.
+             * @param tc The transport catalogue containing bus and stop information.
+             * @param data The graph, stop vertices and routes table loaded from the serialized base.
              */
-            TransportRouter(transport_catalogue::TransportCatalogue& tc);
+            TransportRouter(transport_catalogue::TransportCatalogue& tc, TransportRouterData data);
+
+            TransportRouter(const TransportRouter&) = delete;
+            TransportRouter& operator=(const TransportRouter&) = delete;
 
             /**
              * @brief Adds knots (vertices) to the graph based on the bus routes.
+             * The edges of the buses are collected in parallel; the graph does not depend on the thread count.
              */
             void AddKnots();
 
+            /**
+             * @brief Applies the current wait time and velocity of the catalogue without rebuilding the graph.
+             * The edge weights are derived again from the stored road distances in linear time. The Dijkstra
+             * engine needs nothing more and RAPTOR recomputes its ride times; the other engines refresh
+             * their precomputed data. The route cache is cleared.
+             */
+            void UpdateRouteSettings();
+
+            /**
+             * @brief Adds the edges of a bus of the catalogue to the graph without rebuilding the router.
+             * The all-pairs table is relaxed through the new edges; the other engines refresh their data.
+             * @param bus_name The name of the bus, already added to the catalogue with its stops and distances.
+             * @throws std::invalid_argument if the catalogue has no such bus.
+             */
+            void AddBus(std::string_view bus_name);
+
+            /**
+             * @brief Removes the edges of a bus from the graph without rebuilding the router.
+             * The bus stays in the catalogue but no route rides it. Only the sources of the all-pairs table
+             * whose routes rode the bus are searched again; the other engines refresh their data.
+             * @param bus_name The name of the bus.
+             * @throws std::invalid_argument if the catalogue has no such bus.
+             */
+            void RemoveBus(std::string_view bus_name);
+
             /**
              * @brief Finds the route and buses between two stops.
              * @param stop_name_from The name of the starting stop.
@@ -64,12 +155,172 @@ namespace graph {
              */
             std::optional<DestinationInfo> GetRouteAndBuses(std::string_view stop_name_from, std::string_view stop_name_to);
 
+            /**
+             * @brief Finds the route and buses between two stops avoiding some stops and buses within a time limit and a compute budget.
+             * Requests without exclusions are answered by the selected router, the others bypass it; restricted requests bypass the route cache.
+             * @param stop_name_from The name of the starting stop.
+             * @param stop_name_to The name of the destination stop.
+             * @param restrictions The stops and buses to avoid and the bounds of the search.
+             * @return The route, or std::nullopt if the route is not found within the time limit or either stop is avoided.
+             * @throws SearchTimeoutError if the search runs out of its compute budget.
+             */
+            std::optional<DestinationInfo> GetRouteAndBuses(std::string_view stop_name_from, std::string_view stop_name_to,
+                                                            const RouteRestrictions& restrictions);
+
+            /**
+             * @brief The cache of finished routes keyed by the catalogue ids of the two stops.
+             */
+            using RouteCache = cache::LruCache<uint64_t, std::optional<DestinationInfo>>;
+
+            /**
+             * @brief Enables the route cache of GetRouteAndBuses, dropping the cached routes.
+             * @param capacity The maximum number of cached routes. Zero disables the cache.
+             */
+            void SetRouteCacheCapacity(size_t capacity);
+
+            /**
+             * @brief Retrieves the route cache.
+             * @return The route cache, or nullptr if it is disabled.
+             */
+            const RouteCache* GetRouteCache() const;
+
+            /**
+             * @brief Finds the routes from one stop to several stops, sharing the search work between them.
+             * @param stop_name_from The name of the starting stop.
+             * @param stop_names_to The names of the destination stops.
+             * @return The routes in the order of the destination stops, std::nullopt where a route is not found.
+             */
+            std::vector<std::optional<DestinationInfo>> GetRoutesAndBuses(std::string_view stop_name_from, const std::vector<std::string_view>& stop_names_to);
+
+            /**
+             * @brief Computes the total times between every origin and every destination stop without building the routes.
+             * @param stop_names_from The names of the origin stops.
+             * @param stop_names_to The names of the destination stops.
+             * @return The times by origin, then destination; std::nullopt where a stop is not found or the route does not exist.
+             */
+            std::vector<std::vector<std::optional<double>>> GetRouteMatrix(const std::vector<std::string_view>& stop_names_from,
+                                                                           const std::vector<std::string_view>& stop_names_to);
+
+            /**
+             * @brief Finds every stop reachable from a stop within a time budget with one bounded search.
+             * @param stop_name_from The name of the starting stop.
+             * @param max_time The time budget in minutes.
+             * @return The reachable stops, the starting stop included, ordered by time and then by name;
+             * std::nullopt if the stop is not found.
+             */
+            std::optional<std::vector<ReachableStop>> GetReachableStops(std::string_view stop_name_from, double max_time);
+
+            /**
+             * @brief Retrieves the graph built from the bus routes.
+             * @return The directed weighted graph.
+             */
+            const DirectedWeightedGraph<double>& GetGraph() const;
+
+            /**
+             * @brief Retrieves the vertices of the stops served by buses.
+             * @return Pairs of stop index in the catalogue and its vertex.
+             */
+            std::vector<std::pair<size_t, VertexId>> GetStopVertices() const;
+
+            /**
+             * @brief Retrieves the weakly connected components of the graph.
+             * @return The component label of every vertex.
+             */
+            const std::vector<uint32_t>& GetVertexComponents() const;
+
+            /**
+             * @brief Retrieves the all-pairs router.
+             * @return The router, or nullptr if another router engine is used.
+             */
+            const TableRouter* GetRouter() const;
+
+            /**
+             * @brief Retrieves the contraction hierarchy.
+             * @return The contraction hierarchy, or nullptr if another router engine is used.
+             */
+            const ContractionHierarchy<double>* GetContractionHierarchy() const;
+
+            /**
+             * @brief Retrieves the ALT router.
+             * @return The ALT router, or nullptr if another router engine is used.
+             */
+            const AltRouter<double>* GetAltRouter() const;
+
+            /**
+             * @brief Retrieves the number of parallel edges dropped while building the graph.
+             * @return The number of edges dropped by AddKnots.
+             */
+            size_t GetRemovedEdgeCount() const;
+
+            /**
+             * @brief Computes the fingerprint of the graph and the route settings, identifying the all-pairs table written for them.
+             * @return The fingerprint stored in the base and in the routes table file.
+             */
+            uint64_t GetRouterTableFingerprint() const;
+
+            /**
+             * @brief Retrieves the buses whose edges are in the graph.
+             * @return Whether every bus by catalogue id is routed; the buses added to the catalogue since are not.
+             */
+            const std::vector<bool>& GetRoutedBuses() const;
+
         private:
             transport_catalogue::TransportCatalogue& tc; /**< The transport catalogue */
             DirectedWeightedGraph<double> graph_; /**< The directed weighted graph representing the activities and routes */
             std::unordered_map<std::string_view, size_t> stop_to_vertex_; /**< The map of stop names to vertex indices in the graph */
-            std::unique_ptr<graph::Router<double>> router_; /**< The router for finding routes in the graph */
+            std::vector<uint32_t> vertex_to_stop_; /**< The catalogue id of the stop of every vertex */
+            std::vector<uint32_t> vertex_components_; /**< The weakly connected component of every vertex */
+            std::vector<bool> routed_buses_; /**< Whether the edges of every bus by catalogue id are in the graph */
+            size_t removed_edge_count_ = 0; /**< The number of parallel edges dropped by AddKnots */
+            std::unique_ptr<MappedRouterTable> mapped_router_table_; /**< The mapped all-pairs table used by router_, if any */
+            std::vector<TableWeight> table_weights_; /**< The weight of every edge of graph_ in tenths of a second, set for RouterEngine::ALL_PAIRS */
+            std::unique_ptr<graph::TableRouter> router_; /**< The all-pairs router over graph_ and table_weights_, set for RouterEngine::ALL_PAIRS */
+            std::unique_ptr<graph::DijkstraRouter<double>> dijkstra_router_; /**< The per-query router, set for RouterEngine::DIJKSTRA */
+            std::unique_ptr<graph::ContractionHierarchy<double>> contraction_hierarchy_; /**< The shortcut router, set for RouterEngine::CONTRACTION_HIERARCHIES */
+            std::unique_ptr<graph::AltRouter<double>> alt_router_; /**< The landmark-guided router, set for RouterEngine::ALT */
+            std::unique_ptr<graph::RaptorRouter> raptor_router_; /**< The round-based router, set for RouterEngine::RAPTOR; graph_ stays empty */
+            std::unique_ptr<graph::RaptorRouter> restricted_router_; /**< The round-based router of the restricted requests of the other engines, built on demand */
+            std::unique_ptr<RouteCache> route_cache_; /**< The finished routes of GetRouteAndBuses, if the cache is enabled */
+
+            /**
+             * @brief Builds the route between two vertices with the router selected in the route settings.
+             * @param from The starting vertex.
+             * @param to The destination vertex.
+             * @param limits The bounds of the search.
+             * @return The route info, or std::nullopt if the route is not found within the time limit.
+             */
+            std::optional<graph::Router<double>::RouteInfo> BuildRoute(VertexId from, VertexId to, const SearchLimits<double>& limits = {}) const;
+
+            /**
+             * @brief Finds the route and buses between two stops with the selected router, bypassing the route cache.
+             * @param stop_name_from The name of the starting stop.
+             * @param stop_name_to The name of the destination stop.
+             * @param limits The bounds of the search.
+             * @return The route, or std::nullopt if the stops are not found or the route does not exist within the time limit.
+             */
+            std::optional<DestinationInfo> FindRouteAndBuses(std::string_view stop_name_from, std::string_view stop_name_to,
+                                                             const SearchLimits<double>& limits = {});
 
+            /**
+             * @brief Converts the edges of a route to the waiting and bus activities.
+             * @param route_info The route found by the router.
+             * @return The DestinationInfo structure with the activities and the total time.
+             */
+            DestinationInfo MakeDestinationInfo(const graph::Router<double>::RouteInfo& route_info) const;
+
+            /**
+             * @brief Converts the rides of a RAPTOR route to the waiting and bus activities.
+             * @param raptor_router The RAPTOR router that found the route.
+             * @param route_info The route found by the RAPTOR router.
+             * @return The DestinationInfo structure with the activities and the total time.
+             */
+            DestinationInfo MakeDestinationInfo(const graph::RaptorRouter& raptor_router, const graph::RaptorRouter::RouteInfo& route_info) const;
+
+            /**
+             * @brief Retrieves the RAPTOR router answering the restricted route requests.
+             * @return The selected RAPTOR router, or one built from the routed buses on the first call with another engine.
+             */
+            const graph::RaptorRouter& GetRestrictedRouter();
 
 
             /**
@@ -86,18 +337,96 @@ namespace graph {
              */
             bool ChekExistValue(std::string_view key);
 
+            /**
+             * @struct VertexAssignment
+             * @brief The vertices of the stops served by the routed buses, computed before they replace the current ones.
+             */
+            struct VertexAssignment {
+                std::vector<std::optional<VertexId>> stop_vertices; /**< The vertex of every stop by catalogue id */
+                std::unordered_map<std::string_view, size_t> stop_to_vertex; /**< The map of stop names to vertex indices */
+                std::vector<uint32_t> vertex_to_stop; /**< The catalogue id of the stop of every vertex; its size is the vertex count */
+            };
+
+            /**
+             * @brief Assigns a vertex to every stop served by a bus, in the order of the stops in the catalogue.
+             * @return The vertex of every stop by catalogue id; the stops no bus serves get no vertex.
+             */
+            std::vector<std::optional<VertexId>> AssignVertices();
+
+            /**
+             * @brief Finds the stops served by the given buses.
+             * @param routed_buses Whether every bus by catalogue id is routed.
+             * @return Whether every stop by catalogue id is served.
+             */
+            std::vector<bool> FindServedStops(const std::vector<bool>& routed_buses) const;
+
+            /**
+             * @brief Keeps the vertices of the stops still served by the given buses and gives free or new vertices to the newly served ones.
+             * @param routed_buses Whether every bus by catalogue id is routed.
+             * @return The new vertices; the current ones are left unchanged.
+             */
+            VertexAssignment UpdateVertices(const std::vector<bool>& routed_buses) const;
+
+            /**
+             * @brief Collects the edges of the given buses in parallel and adds the dominating ones to a graph.
+             * @param graph The graph the edges are added to.
+             * @param stop_vertices The vertex of every stop by catalogue id.
+             * @param routed_buses Whether every bus by catalogue id is routed.
+             * @return The number of parallel edges dropped.
+             */
+            size_t AddBusEdges(DirectedWeightedGraph<double>& graph, const std::vector<std::optional<VertexId>>& stop_vertices,
+                               const std::vector<bool>& routed_buses) const;
+
+            /**
+             * @brief Rebuilds the graph for a new set of routed buses and updates the router.
+             * @param routed_buses Whether every bus by catalogue id is routed after the update.
+             * @param is_bus_added Whether a bus was added; otherwise one was removed.
+             */
+            void UpdateBuses(std::vector<bool> routed_buses, bool is_bus_added);
+
+            /**
+             * @brief Collects the edges of a range of buses.
+             * @param stop_vertices The vertex of every stop by catalogue id, as assigned by AssignVertices.
+             * @param routed_buses Whether every bus by catalogue id is routed.
+             * @param first The index of the first bus in the catalogue.
+             * @param last The index past the last bus in the catalogue.
+             * @return The edges of the buses, parallel edges included.
+             */
+            std::vector<Edge<double>> CollectEdges(const std::vector<std::optional<VertexId>>& stop_vertices,
+                                                   const std::vector<bool>& routed_buses, size_t first, size_t last) const;
+
             /**
              * @brief Adds stops to the graph in one direction for a given bus.
-             * @param stops The deque of stop names in the bus route.
-             * @param bus_name The name of the bus.
+             * @param vertices The vertices of the stops in the order of this direction.
+             * @param prefix_sums The prefix sums of the distances in the order of this direction.
+             * @param bus_id The catalogue id of the bus.
+             * @param edges The edges the new ones are appended to.
              */
-            void AddStopsOneDirection(const std::deque<std::string_view>& stops, const std::string& bus_name);
+            void AddStopsOneDirection(const std::vector<size_t>& vertices, const domain::RoutePrefixSums& prefix_sums,
+                                      uint32_t bus_id, std::vector<Edge<double>>& edges) const;
 
             /**
              * @brief Adds stops to the graph in both directions for a given bus.
-             * @param stops The deque of stop names in the bus route.
-             * @param bus_name The name of the bus.
+             * @param vertices The vertices of the stops in the order of the bus stops.
+             * @param bus The bus.
+             * @param edges The edges the new ones are appended to.
+             */
+            void AddStopsNonRoundTrip(std::vector<size_t> vertices, const domain::Bus& bus, std::vector<Edge<double>>& edges) const;
+
+            /**
+             * @brief Adds to a graph the cheapest edge of every (from, to) pair and drops the others.
+             * @param graph The graph the edges are added to.
+             * @param edges The edges of all the buses.
+             * @return The number of edges dropped.
+             */
+            static size_t AddDominatingEdges(DirectedWeightedGraph<double>& graph, std::vector<Edge<double>> edges);
+
+            /**
+             * @brief Computes the table weights of the edges of a graph, rounding the weights to tenths of a second.
+             * @param graph The graph with the weights in minutes.
+             * @return The weight of every edge by id, to build the all-pairs router with.
+             * @throws std::out_of_range if a weight does not fit the table weight.
              */
-            void AddStopsNonRoundTrip(std::deque<std::string_view> stops, const std::string& bus_name);
+            static std::vector<TableWeight> ComputeTableWeights(const DirectedWeightedGraph<double>& graph);
 	};
 } // namespace graph
\ No newline at end of file